@@ -0,0 +1,24 @@
+#ifndef _GPIO_H_
+#define _GPIO_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef int gpio_num_t;
+
+typedef enum {
+    GPIO_MODE_OUTPUT = 2
+} gpio_mode_t;
+
+typedef struct {
+    uint64_t pin_bit_mask;
+    gpio_mode_t mode;
+} gpio_config_t;
+
+/* No pins on the host, these succeed and do nothing */
+esp_err_t gpio_config( const gpio_config_t* Config );
+esp_err_t gpio_set_level( gpio_num_t Pin, uint32_t Level );
+esp_err_t gpio_hold_en( gpio_num_t Pin );
+void gpio_deep_sleep_hold_en( void );
+
+#endif
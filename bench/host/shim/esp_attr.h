@@ -0,0 +1,9 @@
+#ifndef _ESP_ATTR_H_
+#define _ESP_ATTR_H_
+
+/* Memory placement means nothing on the host */
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_NOINIT_ATTR
+
+#endif
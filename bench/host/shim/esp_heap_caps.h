@@ -0,0 +1,12 @@
+#ifndef _ESP_HEAP_CAPS_H_
+#define _ESP_HEAP_CAPS_H_
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_DMA ( 1 << 3 )
+#define MALLOC_CAP_8BIT ( 1 << 2 )
+
+#define heap_caps_malloc( Size, Caps ) malloc( Size )
+#define heap_caps_free( Pointer ) free( Pointer )
+
+#endif
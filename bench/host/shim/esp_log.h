@@ -0,0 +1,12 @@
+#ifndef _ESP_LOG_H_
+#define _ESP_LOG_H_
+
+#include <stdio.h>
+
+/* Errors and warnings go to stderr so they stay out of benchmark output */
+#define ESP_LOGE( Tag, Format, ... ) fprintf( stderr, "E %s: " Format "\n", Tag, ##__VA_ARGS__ )
+#define ESP_LOGW( Tag, Format, ... ) fprintf( stderr, "W %s: " Format "\n", Tag, ##__VA_ARGS__ )
+#define ESP_LOGI( Tag, Format, ... ) fprintf( stderr, "I %s: " Format "\n", Tag, ##__VA_ARGS__ )
+#define ESP_LOGD( Tag, Format, ... )
+
+#endif
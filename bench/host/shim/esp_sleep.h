@@ -0,0 +1,15 @@
+#ifndef _ESP_SLEEP_H_
+#define _ESP_SLEEP_H_
+
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED = 0,
+    ESP_SLEEP_WAKEUP_TIMER = 4
+} esp_sleep_wakeup_cause_t;
+
+/* A cold boot on the host unless HostSetWakeupCause says otherwise */
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause( void );
+
+/* Host only, pretends the next boot woke from deep sleep for testing TTFT_InitFlag_Resume */
+void HostSetWakeupCause( esp_sleep_wakeup_cause_t Cause );
+
+#endif
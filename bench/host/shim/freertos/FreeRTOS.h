@@ -0,0 +1,26 @@
+#ifndef _FREERTOS_H_
+#define _FREERTOS_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+
+/* One tick per millisecond */
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define portMAX_DELAY ( ( TickType_t ) 0xFFFFFFFF )
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS( Ms ) ( ( TickType_t ) ( Ms ) )
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS 1
+
+#ifndef BIT
+    #define BIT( n ) ( 1UL << ( n ) )
+#endif
+
+#endif
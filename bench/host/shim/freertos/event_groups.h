@@ -0,0 +1,15 @@
+#ifndef _EVENT_GROUPS_H_
+#define _EVENT_GROUPS_H_
+
+#include "freertos/FreeRTOS.h"
+
+typedef uint32_t EventBits_t;
+typedef struct HostEventGroup* EventGroupHandle_t;
+
+/* Nothing else runs, so waiting just returns the bits that are set */
+EventGroupHandle_t xEventGroupCreate( void );
+void vEventGroupDelete( EventGroupHandle_t Group );
+EventBits_t xEventGroupSetBits( EventGroupHandle_t Group, EventBits_t Bits );
+EventBits_t xEventGroupWaitBits( EventGroupHandle_t Group, EventBits_t Bits, BaseType_t ClearOnExit, BaseType_t WaitForAll, TickType_t Timeout );
+
+#endif
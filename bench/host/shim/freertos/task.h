@@ -0,0 +1,20 @@
+#ifndef _TASK_H_
+#define _TASK_H_
+
+#include "freertos/FreeRTOS.h"
+
+typedef void* TaskHandle_t;
+
+/*
+ * There is no scheduler, tasks run to completion inside xTaskCreate and
+ * delays return straight away so benchmarks don't time the init sequence sleeping.
+ */
+BaseType_t xTaskCreate( void ( *Task ) ( void* ), const char* Name, uint32_t StackDepth, void* Param, UBaseType_t Priority, TaskHandle_t* OutHandle );
+void vTaskDelete( TaskHandle_t Task );
+void vTaskDelay( TickType_t Ticks );
+TickType_t xTaskGetTickCount( void );
+UBaseType_t uxTaskPriorityGet( TaskHandle_t Task );
+
+#define taskYIELD( )
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef _SDKCONFIG_H_
+#define _SDKCONFIG_H_
+
+/* Host builds have no menuconfig, nothing the component reads is set */
+
+#endif
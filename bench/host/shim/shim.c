@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2018 Tara Keeling
+ *
+ * This software is released under the MIT License.
+ * https://opensource.org/licenses/MIT
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "driver/gpio.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+
+/*
+ * Just enough of FreeRTOS and ESP-IDF for the component to run on a PC.
+ */
+struct HostEventGroup {
+    EventBits_t Bits;
+};
+
+int64_t esp_timer_get_time( void ) {
+    struct timespec Now;
+
+    clock_gettime( CLOCK_MONOTONIC, &Now );
+    return ( ( int64_t ) Now.tv_sec * 1000000 ) + ( Now.tv_nsec / 1000 );
+}
+
+static esp_sleep_wakeup_cause_t WakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause( void ) {
+    return WakeupCause;
+}
+
+void HostSetWakeupCause( esp_sleep_wakeup_cause_t Cause ) {
+    WakeupCause = Cause;
+}
+
+BaseType_t xTaskCreate( void ( *Task ) ( void* ), const char* Name, uint32_t StackDepth, void* Param, UBaseType_t Priority, TaskHandle_t* OutHandle ) {
+    if ( OutHandle != NULL ) {
+        *OutHandle = NULL;
+    }
+
+    Task( Param );
+    return pdPASS;
+}
+
+void vTaskDelete( TaskHandle_t Task ) {
+}
+
+void vTaskDelay( TickType_t Ticks ) {
+}
+
+TickType_t xTaskGetTickCount( void ) {
+    return ( TickType_t ) ( esp_timer_get_time( ) / 1000 );
+}
+
+UBaseType_t uxTaskPriorityGet( TaskHandle_t Task ) {
+    return 1;
+}
+
+EventGroupHandle_t xEventGroupCreate( void ) {
+    return calloc( 1, sizeof( struct HostEventGroup ) );
+}
+
+void vEventGroupDelete( EventGroupHandle_t Group ) {
+    free( Group );
+}
+
+EventBits_t xEventGroupSetBits( EventGroupHandle_t Group, EventBits_t Bits ) {
+    Group->Bits|= Bits;
+    return Group->Bits;
+}
+
+EventBits_t xEventGroupWaitBits( EventGroupHandle_t Group, EventBits_t Bits, BaseType_t ClearOnExit, BaseType_t WaitForAll, TickType_t Timeout ) {
+    EventBits_t Result = Group->Bits;
+
+    if ( ClearOnExit == pdTRUE ) {
+        Group->Bits&= ~Bits;
+    }
+
+    return Result;
+}
+
+esp_err_t gpio_config( const gpio_config_t* Config ) {
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level( gpio_num_t Pin, uint32_t Level ) {
+    return ESP_OK;
+}
+
+esp_err_t gpio_hold_en( gpio_num_t Pin ) {
+    return ESP_OK;
+}
+
+void gpio_deep_sleep_hold_en( void ) {
+}
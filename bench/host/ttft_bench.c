@@ -0,0 +1,154 @@
+/**
+ * Copyright (c) 2018 Tara Keeling
+ *
+ * This software is released under the MIT License.
+ * https://opensource.org/licenses/MIT
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "ttft.h"
+#include "ttft_font.h"
+#include "ttft_profile.h"
+#include "scenarios.h"
+
+/*
+ * Host benchmarks for the drawing primitives, fonts and update conversion.
+ *
+ * Usage: ttft_bench [-t milliseconds] [filter]
+ * Runs every scenario whose name contains (filter) for at least -t milliseconds (default 100)
+ * and prints one line per scenario:
+ * scenario=<name> ns_per_op=<n> pixels_per_s=<n> iterations=<n>
+ *
+ * Nothing is sent anywhere, updates time the conversion and not a transport.
+ */
+
+#define DefaultMinTimeMs 100
+
+/* Runs before timing starts so caches and the fill buffer are warm */
+#define WarmupIterations 8
+
+static bool BenchOpen( struct TTFT_Device* DeviceHandle, void* Param );
+static void BenchClose( struct TTFT_Device* DeviceHandle );
+static void BenchWrite( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t Length, bool IsCommand, bool Poll );
+static bool BenchQueue( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t Length, bool IsCommand );
+static void BenchWait( struct TTFT_Device* DeviceHandle );
+static void BenchSetReset( struct TTFT_Device* DeviceHandle, bool Level );
+
+/* Throws everything away */
+static const struct TTFT_TransportOps BenchTransport = {
+    .Open = BenchOpen,
+    .Close = BenchClose,
+    .Write = BenchWrite,
+    .Queue = BenchQueue,
+    .Wait = BenchWait,
+    .SetReset = BenchSetReset,
+    .Lock = NULL,
+    .Unlock = NULL
+};
+
+static bool BenchOpen( struct TTFT_Device* DeviceHandle, void* Param ) {
+    return true;
+}
+
+static void BenchClose( struct TTFT_Device* DeviceHandle ) {
+}
+
+static void BenchWrite( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t Length, bool IsCommand, bool Poll ) {
+}
+
+static bool BenchQueue( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t Length, bool IsCommand ) {
+    return true;
+}
+
+static void BenchWait( struct TTFT_Device* DeviceHandle ) {
+}
+
+static void BenchSetReset( struct TTFT_Device* DeviceHandle, bool Level ) {
+}
+
+/*
+ * BenchNow:
+ * Returns nanoseconds from a monotonic clock.
+ */
+static int64_t BenchNow( void ) {
+    struct timespec Now;
+
+    clock_gettime( CLOCK_MONOTONIC, &Now );
+    return ( ( int64_t ) Now.tv_sec * 1000000000 ) + Now.tv_nsec;
+}
+
+/*
+ * BenchScenario:
+ * Times (Scenario) for at least (MinTimeNs) and prints the result.
+ */
+static void BenchScenario( struct TTFT_Device* DeviceHandle, const struct TTFT_BenchScenario* Scenario, int64_t MinTimeNs ) {
+    int64_t Elapsed = 0;
+    int64_t Pixels = 0;
+    int64_t Start = 0;
+    int Iterations = 0;
+    int i = 0;
+
+    TTFT_BenchSetup( DeviceHandle, Scenario );
+
+    for ( i = 0; i < WarmupIterations; i++ ) {
+        TTFT_BenchRun( DeviceHandle, Scenario, i );
+    }
+
+    /* Checking the clock in batches keeps it out of the fast scenarios */
+    for ( Start = BenchNow( ); Elapsed < MinTimeNs; Elapsed = BenchNow( ) - Start ) {
+        for ( i = 0; i < 16; i++, Iterations++ ) {
+            Pixels+= TTFT_BenchRun( DeviceHandle, Scenario, Iterations );
+        }
+    }
+
+    printf( "scenario=%s ns_per_op=%.1f pixels_per_s=%.0f iterations=%d\n",
+        Scenario->Name,
+        Elapsed / ( double ) Iterations,
+        Pixels / ( Elapsed / 1000000000.0 ),
+        Iterations
+    );
+}
+
+int main( int Argc, char** Argv ) {
+    static struct TTFT_Device Display;
+    struct TTFT_BenchScenario Scenario;
+    const char* Filter = NULL;
+    int64_t MinTimeNs = DefaultMinTimeMs * 1000000LL;
+    int i = 0;
+
+    for ( i = 1; i < Argc; i++ ) {
+        if ( strcmp( Argv[ i ], "-t" ) == 0 && i + 1 < Argc ) {
+            MinTimeNs = atoi( Argv[ ++i ] ) * 1000000LL;
+        }
+        else {
+            Filter = Argv[ i ];
+        }
+    }
+
+    if ( TTFT_InitTransport( &Display, TTFT_BenchWidth, TTFT_BenchHeight, -1, &BenchTransport, NULL, TTFT_Reset_ILI9341, TTFT_InitFlag_Default ) == false ) {
+        fprintf( stderr, "Failed to initialize display\n" );
+        return 1;
+    }
+
+    for ( i = 0; i < TTFT_BenchGetScenarioCount( ); i++ ) {
+        if ( TTFT_BenchGetScenario( i, &Scenario ) == false ) {
+            continue;
+        }
+
+        if ( Filter == NULL || strstr( Scenario.Name, Filter ) != NULL ) {
+            BenchScenario( &Display, &Scenario, MinTimeNs );
+        }
+    }
+
+    /* Only with TTFT_PROFILE, this is nothing otherwise */
+    TTFT_ProfileReport( stderr );
+
+    TTFT_DeInit( &Display );
+    return 0;
+}
@@ -0,0 +1,244 @@
+/**
+ * Copyright (c) 2018 Tara Keeling
+ *
+ * This software is released under the MIT License.
+ * https://opensource.org/licenses/MIT
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "ttft.h"
+#include "ttft_font.h"
+#include "scenarios.h"
+
+/* Font scenarios per font: native opaque, native transparent and scaled opaque */
+#define FontVariants 3
+
+#define BenchText "Hello, World 0123"
+
+static void DrawSyntheticUI( struct TTFT_Device* DeviceHandle );
+
+static const struct TTFT_BenchScenario Primitives[ ] = {
+    { "clear", TTFT_BenchOp_Clear, TTFT_BenchWidth, TTFT_BenchHeight },
+    { "fill_rect_16x16", TTFT_BenchOp_FillRect, 16, 16 },
+    { "fill_rect_160x120", TTFT_BenchOp_FillRect, 160, 120 },
+    { "draw_line_300x1", TTFT_BenchOp_DrawLine, 300, 1 },
+    { "draw_line_200x150", TTFT_BenchOp_DrawLine, 200, 150 },
+    { "draw_line_60x200", TTFT_BenchOp_DrawLine, 60, 200 },
+    { "draw_box_100x80", TTFT_BenchOp_DrawBox, 100, 80 },
+    { "update_full", TTFT_BenchOp_Update, TTFT_BenchWidth, TTFT_BenchHeight },
+    { "update_synthetic_ui", TTFT_BenchOp_UpdateSyntheticUI, TTFT_BenchWidth, TTFT_BenchHeight },
+    { "update_rect_64x64", TTFT_BenchOp_UpdateRect, 64, 64 }
+};
+
+#define PrimitiveCount ( ( int ) ( sizeof( Primitives ) / sizeof( Primitives[ 0 ] ) ) )
+
+/* A small font scaled up next to native fonts of about the same size, to see what scaling costs */
+static const struct TTFT_BenchScenario ScaledFonts[ ] = {
+    { "font_scaled_char_16x22_x3_opaque", TTFT_BenchOp_FontDrawString, 0, 0, &Font_Char_16x22, 3, false },
+    { "font_scaled_liberation_mono_22x37_opaque", TTFT_BenchOp_FontDrawString, 0, 0, &Font_Liberation_Mono_22x37, 1, false },
+    { "font_scaled_droid_sans_27x35_opaque", TTFT_BenchOp_FontDrawString, 0, 0, &Font_Droid_Sans_27x35, 1, false },
+    { "font_scaled_liberation_mono_31x54_opaque", TTFT_BenchOp_FontDrawString, 0, 0, &Font_Liberation_Mono_31x54, 1, false }
+};
+
+#define ScaledFontCount ( ( int ) ( sizeof( ScaledFonts ) / sizeof( ScaledFonts[ 0 ] ) ) )
+
+static const char* FontVariantNames[ FontVariants ] = {
+    "opaque",
+    "transparent",
+    "x2_opaque"
+};
+
+/*
+ * TTFT_BenchGetScenarioCount:
+ * Returns how many scenarios there are, one set of text scenarios for every built in font.
+ */
+int TTFT_BenchGetScenarioCount( void ) {
+    return PrimitiveCount + ScaledFontCount + ( TTFT_FontGetCount( ) * FontVariants );
+}
+
+/*
+ * TTFT_BenchGetScenario:
+ * Fills in (Scenario) with scenario number (Index).
+ */
+bool TTFT_BenchGetScenario( int Index, struct TTFT_BenchScenario* Scenario ) {
+    const struct TTFT_FontDef* Font = NULL;
+    int Variant = 0;
+    char* c = NULL;
+
+    NullCheck( Scenario, return false );
+    CheckBounds( Index, 0, TTFT_BenchGetScenarioCount( ) - 1, return false );
+
+    if ( Index < PrimitiveCount ) {
+        memcpy( Scenario, &Primitives[ Index ], sizeof( struct TTFT_BenchScenario ) );
+        return true;
+    }
+
+    Index-= PrimitiveCount;
+
+    if ( Index < ScaledFontCount ) {
+        memcpy( Scenario, &ScaledFonts[ Index ], sizeof( struct TTFT_BenchScenario ) );
+        return true;
+    }
+
+    Index-= ScaledFontCount;
+    Variant = Index % FontVariants;
+
+    NullCheck( ( Font = TTFT_FontGetByIndex( Index / FontVariants ) ), return false );
+
+    memset( Scenario, 0, sizeof( struct TTFT_BenchScenario ) );
+
+    Scenario->Op = TTFT_BenchOp_FontDrawString;
+    Scenario->Font = Font;
+    Scenario->FontScale = ( Variant == 2 ) ? 2 : 1;
+    Scenario->IsTransparent = ( Variant == 1 );
+
+    snprintf( Scenario->Name, sizeof( Scenario->Name ), "font_%s_%s", Font->FontName, FontVariantNames[ Variant ] );
+
+    /* Names are used as keys, keep them to one lower case word */
+    for ( c = Scenario->Name; *c; c++ ) {
+        *c = isalnum( ( int ) *c ) ? tolower( ( int ) *c ) : '_';
+    }
+
+    return true;
+}
+
+/*
+ * DrawSyntheticUI:
+ * Draws a typical screen, mostly a plain background and bars of a single colour with some text,
+ * so updates spend most of their time in solid runs rather than converting pixels.
+ */
+static void DrawSyntheticUI( struct TTFT_Device* DeviceHandle ) {
+    char Label[ 16 ];
+    int Width = DeviceHandle->Width;
+    int Height = DeviceHandle->Height;
+    int y = 0;
+    int i = 0;
+
+    TTFT_Clear( DeviceHandle, 16 );
+
+    /* Title and status bars */
+    TTFT_FillRect( DeviceHandle, 0, 0, Width - 1, 27, 40 );
+    TTFT_FillRect( DeviceHandle, 0, Height - 24, Width - 1, Height - 1, 40 );
+
+    TTFT_SetFont( DeviceHandle, &Font_Liberation_Mono_11x19 );
+    TTFT_SetFontScale( DeviceHandle, 1 );
+    TTFT_FontDrawString( DeviceHandle, 6, 4, 250, 40, "Synthetic UI" );
+    TTFT_FontDrawString( DeviceHandle, 6, Height - 21, 250, 40, "Ready" );
+
+    /* Labelled bar graphs */
+    for ( i = 0, y = 36; i < 5; i++, y+= 34 ) {
+        snprintf( Label, sizeof( Label ), "CH%d", i );
+
+        TTFT_FontDrawString( DeviceHandle, 6, y + 4, 250, 16, Label );
+        TTFT_DrawBox( DeviceHandle, 60, y, Width - 11, y + 25, 1, 200 );
+        TTFT_FillRect( DeviceHandle, 62, y + 2, 62 + ( ( i + 1 ) * ( Width - 76 ) ) / 6, y + 23, 80 + ( i * 30 ) );
+    }
+}
+
+/*
+ * TTFT_BenchSetup:
+ * Gets (DeviceHandle) ready to run (Scenario), call before timing it.
+ * The device must be TTFT_BenchWidth x TTFT_BenchHeight with a framebuffer.
+ */
+void TTFT_BenchSetup( struct TTFT_Device* DeviceHandle, const struct TTFT_BenchScenario* Scenario ) {
+    int x = 0;
+    int y = 0;
+    int i = 0;
+
+    NullCheck( DeviceHandle, return );
+    NullCheck( DeviceHandle->FrameBuffer, return );
+    NullCheck( Scenario, return );
+
+    for ( i = 0; i < 256; i++ ) {
+        TTFT_SetPaletteEntry( DeviceHandle, i, i, 255 - i, i * 4 );
+    }
+
+    /* No single colour rows, updates send every pixel through the conversion */
+    for ( y = 0; y < DeviceHandle->Height; y++ ) {
+        for ( x = 0; x < DeviceHandle->Width; x++ ) {
+            DeviceHandle->FrameBuffer[ ( y * DeviceHandle->Width ) + x ] = x ^ y;
+        }
+    }
+
+    if ( Scenario->Op == TTFT_BenchOp_UpdateSyntheticUI ) {
+        DrawSyntheticUI( DeviceHandle );
+    }
+
+    TTFT_ClearDirty( DeviceHandle );
+
+    if ( Scenario->Op == TTFT_BenchOp_FontDrawString ) {
+        TTFT_SetFont( DeviceHandle, Scenario->Font );
+        TTFT_SetFontScale( DeviceHandle, Scenario->FontScale );
+    }
+}
+
+/*
+ * TTFT_BenchRun:
+ * Runs (Scenario) once, (Iteration) moves things around so every run isn't identical.
+ * Returns the number of pixels drawn or sent.
+ */
+int TTFT_BenchRun( struct TTFT_Device* DeviceHandle, const struct TTFT_BenchScenario* Scenario, int Iteration ) {
+    uint8_t Color = Iteration & 0xFF;
+    int Width = Scenario->Width;
+    int Height = Scenario->Height;
+    int x = 0;
+    int y = 0;
+
+    /* Wander about without going off the display */
+    x = ( Iteration * 13 ) % ( ( DeviceHandle->Width - Width ) + 1 );
+    y = ( Iteration * 7 ) % ( ( DeviceHandle->Height - Height ) + 1 );
+
+    switch ( Scenario->Op ) {
+        case TTFT_BenchOp_Clear: {
+            TTFT_Clear( DeviceHandle, Color );
+            return DeviceHandle->Width * DeviceHandle->Height;
+        }
+        case TTFT_BenchOp_FillRect: {
+            TTFT_FillRect( DeviceHandle, x, y, x + Width - 1, y + Height - 1, Color );
+            return Width * Height;
+        }
+        case TTFT_BenchOp_DrawLine: {
+            TTFT_DrawLine( DeviceHandle, x, y, x + Width - 1, y + Height - 1, Color );
+            return ( Width > Height ) ? Width : Height;
+        }
+        case TTFT_BenchOp_DrawBox: {
+            TTFT_DrawBox( DeviceHandle, x, y, x + Width - 1, y + Height - 1, 1, Color );
+            return ( ( Width + Height ) * 2 ) - 4;
+        }
+        case TTFT_BenchOp_FontDrawString: {
+            Width = TTFT_FontMeasureString( DeviceHandle, BenchText );
+            Height = TTFT_FontGetHeight( DeviceHandle );
+
+            x = Iteration % 16;
+            y = Iteration % 8;
+
+            /* Colour 255 is transparent */
+            Color = Iteration % 255;
+            TTFT_FontDrawString( DeviceHandle, x, y, Color, ( Scenario->IsTransparent == true ) ? 255 : 254 - Color, BenchText );
+
+            /* Counts the whole cell, only whatever fits on the display */
+            Width = ( x + Width > DeviceHandle->Width ) ? DeviceHandle->Width - x : Width;
+            Height = ( y + Height > DeviceHandle->Height ) ? DeviceHandle->Height - y : Height;
+
+            return Width * Height;
+        }
+        case TTFT_BenchOp_Update:
+        case TTFT_BenchOp_UpdateSyntheticUI: {
+            TTFT_Update( DeviceHandle );
+            return DeviceHandle->Width * DeviceHandle->Height;
+        }
+        case TTFT_BenchOp_UpdateRect: {
+            TTFT_UpdateRect( DeviceHandle, x, y, x + Width - 1, y + Height - 1 );
+            return Width * Height;
+        }
+        default: break;
+    };
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+#ifndef _TTFT_BENCH_SCENARIOS_H_
+#define _TTFT_BENCH_SCENARIOS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct TTFT_Device;
+struct TTFT_FontDef;
+
+/* Size of the display every scenario is written for */
+#define TTFT_BenchWidth 320
+#define TTFT_BenchHeight 240
+
+/* Longest scenario name, including the terminator */
+#define TTFT_BenchMaxName 64
+
+typedef enum {
+    TTFT_BenchOp_Clear = 0,
+    TTFT_BenchOp_FillRect,
+    TTFT_BenchOp_DrawLine,
+    TTFT_BenchOp_DrawBox,
+    TTFT_BenchOp_FontDrawString,
+    TTFT_BenchOp_Update,
+    TTFT_BenchOp_UpdateRect,
+    TTFT_BenchOp_UpdateSyntheticUI
+} TTFT_BenchOp;
+
+/*
+ * One thing to time, the host and target benchmarks run the same list
+ * so their numbers can be put side by side.
+ */
+struct TTFT_BenchScenario {
+    char Name[ TTFT_BenchMaxName ];
+    TTFT_BenchOp Op;
+
+    /* Size of the rectangle, line, box or update */
+    int Width;
+    int Height;
+
+    /* Only for TTFT_BenchOp_FontDrawString */
+    const struct TTFT_FontDef* Font;
+    int FontScale;
+    bool IsTransparent;
+};
+
+/*
+ * TTFT_BenchGetScenarioCount:
+ * Returns how many scenarios there are, one set of text scenarios for every built in font.
+ */
+int TTFT_BenchGetScenarioCount( void );
+
+/*
+ * TTFT_BenchGetScenario:
+ * Fills in (Scenario) with scenario number (Index).
+ */
+bool TTFT_BenchGetScenario( int Index, struct TTFT_BenchScenario* Scenario );
+
+/*
+ * TTFT_BenchSetup:
+ * Gets (DeviceHandle) ready to run (Scenario), call before timing it.
+ * The device must be TTFT_BenchWidth x TTFT_BenchHeight with a framebuffer.
+ */
+void TTFT_BenchSetup( struct TTFT_Device* DeviceHandle, const struct TTFT_BenchScenario* Scenario );
+
+/*
+ * TTFT_BenchRun:
+ * Runs (Scenario) once, (Iteration) moves things around so every run isn't identical.
+ * Returns the number of pixels drawn or sent.
+ */
+int TTFT_BenchRun( struct TTFT_Device* DeviceHandle, const struct TTFT_BenchScenario* Scenario, int Iteration );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef _TTFT_TARGET_BENCH_H_
+#define _TTFT_TARGET_BENCH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct TTFT_Device;
+
+/* ILI9341 wiring on the m5 stack */
+#define BenchMOSIPin 23
+#define BenchMISOPin 19
+#define BenchSCLKPin 18
+#define BenchCSPin 14
+#define BenchDCPin 27
+#define BenchResetPin 33
+#define BenchBacklightPin 32
+#define BenchSPIFrequency 40000000
+
+/*
+ * BenchScenarios:
+ * Times every scenario in bench/scenarios.c with the CPU cycle counter.
+ */
+void BenchScenarios( struct TTFT_Device* DeviceHandle );
+
+/*
+ * BenchClocks:
+ * Re-initializes (DeviceHandle) at several SPI clocks and prints a table of update times.
+ * The display is left at BenchSPIFrequency.
+ */
+void BenchClocks( struct TTFT_Device* DeviceHandle );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
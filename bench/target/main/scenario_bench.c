@@ -0,0 +1,188 @@
+/**
+ * Copyright (c) 2018 Tara Keeling
+ * 
+ * This software is released under the MIT License.
+ * https://opensource.org/licenses/MIT
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "ttft.h"
+#include "ttft_profile.h"
+#include "scenarios.h"
+#include "bench.h"
+
+#if defined CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+#define BenchCPUMHz CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+#elif defined CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ
+#define BenchCPUMHz CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ
+#else
+#define BenchCPUMHz 240
+#endif
+
+/* Each scenario runs for at least this long, like -t on the host */
+#define BenchMinTimeMs 100
+
+/* Runs before timing starts so caches and the fill buffer are warm */
+#define WarmupIterations 8
+
+/*
+ * Short enough that the cycle counter can't wrap during a batch,
+ * even for full updates at the slowest clock.
+ */
+#define BatchIterations 4
+
+static const int ClockTable[ ] = {
+    10000000,
+    20000000,
+    26666666,
+    40000000
+};
+
+#define ClockCount ( ( int ) ( sizeof( ClockTable ) / sizeof( ClockTable[ 0 ] ) ) )
+
+/* Updates per clock for the table */
+#define ClockFrames 10
+
+/*
+ * BenchScenario:
+ * Times (Scenario) for at least BenchMinTimeMs and prints the result,
+ * in the same format as bench/host with cycles added.
+ */
+static void BenchScenario( struct TTFT_Device* DeviceHandle, const struct TTFT_BenchScenario* Scenario ) {
+    const uint64_t MinCycles = ( uint64_t ) BenchMinTimeMs * BenchCPUMHz * 1000;
+    uint64_t Cycles = 0;
+    int64_t Pixels = 0;
+    uint32_t Start = 0;
+    int Iterations = 0;
+    int i = 0;
+
+    TTFT_BenchSetup( DeviceHandle, Scenario );
+
+    for ( i = 0; i < WarmupIterations; i++ ) {
+        TTFT_BenchRun( DeviceHandle, Scenario, i );
+    }
+
+    while ( Cycles < MinCycles ) {
+        Start = TTFT_ProfileCycles( );
+
+        for ( i = 0; i < BatchIterations; i++, Iterations++ ) {
+            Pixels+= TTFT_BenchRun( DeviceHandle, Scenario, Iterations );
+        }
+
+        /* Unsigned so a single wrap still comes out right */
+        Cycles+= ( uint32_t ) ( TTFT_ProfileCycles( ) - Start );
+    }
+
+    printf( "scenario=%s ns_per_op=%.1f pixels_per_s=%.0f iterations=%d cycles_per_op=%.0f\n",
+        Scenario->Name,
+        ( Cycles * 1000.0 ) / ( ( double ) BenchCPUMHz * Iterations ),
+        Pixels / ( Cycles / ( BenchCPUMHz * 1000000.0 ) ),
+        Iterations,
+        Cycles / ( double ) Iterations
+    );
+}
+
+/*
+ * BenchScenarios:
+ * Times every scenario in bench/scenarios.c with the CPU cycle counter.
+ */
+void BenchScenarios( struct TTFT_Device* DeviceHandle ) {
+    struct TTFT_BenchScenario Scenario;
+    int i = 0;
+
+    NullCheck( DeviceHandle, return );
+
+    for ( i = 0; i < TTFT_BenchGetScenarioCount( ); i++ ) {
+        if ( TTFT_BenchGetScenario( i, &Scenario ) == true ) {
+            BenchScenario( DeviceHandle, &Scenario );
+        }
+
+        /* Let the idle task in so the watchdog stays quiet */
+        vTaskDelay( 1 );
+    }
+}
+
+/*
+ * BenchUpdateCycles:
+ * Returns the average cycles taken by (Frames) updates of a (Width) x (Height) rectangle.
+ */
+static uint32_t BenchUpdateCycles( struct TTFT_Device* DeviceHandle, int Width, int Height, int Frames ) {
+    uint64_t Cycles = 0;
+    uint32_t Start = 0;
+    int i = 0;
+
+    for ( i = 0; i < Frames; i++ ) {
+        Start = TTFT_ProfileCycles( );
+
+        if ( Width == DeviceHandle->Width && Height == DeviceHandle->Height ) {
+            TTFT_Update( DeviceHandle );
+        }
+        else {
+            TTFT_UpdateRect( DeviceHandle, 0, 0, Width - 1, Height - 1 );
+        }
+
+        Cycles+= ( uint32_t ) ( TTFT_ProfileCycles( ) - Start );
+    }
+
+    return ( uint32_t ) ( Cycles / Frames );
+}
+
+/*
+ * BenchClocks:
+ * Re-initializes (DeviceHandle) at several SPI clocks and prints a table of update times.
+ * The display is left at BenchSPIFrequency.
+ */
+void BenchClocks( struct TTFT_Device* DeviceHandle ) {
+    struct TTFT_BenchScenario Scenario;
+    uint32_t FullCycles = 0;
+    uint32_t RectCycles = 0;
+    int Width = 0;
+    int Height = 0;
+    int i = 0;
+
+    NullCheck( DeviceHandle, return );
+
+    Width = DeviceHandle->Width;
+    Height = DeviceHandle->Height;
+
+    /* Any update scenario gets the palette and framebuffer ready */
+    memset( &Scenario, 0, sizeof( Scenario ) );
+    Scenario.Op = TTFT_BenchOp_Update;
+
+    printf( "%10s %12s %12s %8s %12s\n", "spi_hz", "full_us", "full_cycles", "full_fps", "rect64_us" );
+
+    for ( i = 0; i < ClockCount; i++ ) {
+        TTFT_DeInit( DeviceHandle );
+
+        if ( TTFT_Init( DeviceHandle, Width, Height, BenchCSPin, BenchDCPin, BenchResetPin, BenchBacklightPin, TTFT_Reset_ILI9341, ClockTable[ i ] ) == false ) {
+            printf( "%10d failed to initialize\n", ClockTable[ i ] );
+            continue;
+        }
+
+        TTFT_BenchSetup( DeviceHandle, &Scenario );
+        TTFT_SetBacklight( DeviceHandle, true );
+
+        FullCycles = BenchUpdateCycles( DeviceHandle, Width, Height, ClockFrames );
+        RectCycles = BenchUpdateCycles( DeviceHandle, 64, 64, ClockFrames );
+
+        printf( "%10d %12.0f %12u %8.1f %12.0f\n",
+            ClockTable[ i ],
+            FullCycles / ( double ) BenchCPUMHz,
+            ( unsigned ) FullCycles,
+            ( BenchCPUMHz * 1000000.0 ) / FullCycles,
+            RectCycles / ( double ) BenchCPUMHz
+        );
+
+        vTaskDelay( 1 );
+    }
+
+    TTFT_DeInit( DeviceHandle );
+    TTFT_Init( DeviceHandle, Width, Height, BenchCSPin, BenchDCPin, BenchResetPin, BenchBacklightPin, TTFT_Reset_ILI9341, BenchSPIFrequency );
+}
@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) 2018 Tara Keeling
+ * 
+ * This software is released under the MIT License.
+ * https://opensource.org/licenses/MIT
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/spi_master.h"
+#include "esp_timer.h"
+#include "ttft.h"
+#include "bench.h"
+
+#define BenchWidth 320
+#define BenchHeight 240
+
+/* Address window changes, three commands each */
+#define BenchWindowCount 2000
+
+#define BenchFrameCount 20
+
+static const char* TransportNames[ ] = {
+    "auto",
+    "polling",
+    "interrupt",
+    "queued"
+};
+
+/*
+ * BenchTransport:
+ * Prints commands per second and average full frame time for (Transport).
+ */
+static void BenchTransport( struct TTFT_Device* DeviceHandle, TTFT_Transport Transport ) {
+    int64_t CommandTime = 0;
+    int64_t FrameTime = 0;
+    int64_t Start = 0;
+    int i = 0;
+
+    TTFT_SetTransport( DeviceHandle, Transport, TTFT_DefaultPollingThreshold );
+
+    /* Held like an update would, so only the transfers themselves are timed */
+    TTFT_AcquireBus( DeviceHandle );
+    Start = esp_timer_get_time( );
+
+    for ( i = 0; i < BenchWindowCount; i++ ) {
+        TTFT_PanelSetWindow( DeviceHandle, 0, 0, BenchWidth - 1, BenchHeight - 1 );
+    }
+
+    CommandTime = esp_timer_get_time( ) - Start;
+    TTFT_ReleaseBus( DeviceHandle );
+
+    Start = esp_timer_get_time( );
+
+    for ( i = 0; i < BenchFrameCount; i++ ) {
+        TTFT_Update( DeviceHandle );
+    }
+
+    FrameTime = esp_timer_get_time( ) - Start;
+
+    printf( "transport=%s commands_per_s=%.0f frame_us=%.0f\n",
+        TransportNames[ Transport ],
+        ( BenchWindowCount * 3 ) / ( CommandTime / 1000000.0 ),
+        FrameTime / ( double ) BenchFrameCount
+    );
+}
+
+void app_main( void ) {
+    static struct TTFT_Device Display;
+    int x = 0;
+    int y = 0;
+    int i = 0;
+
+    if ( SPIMasterInit( BenchMOSIPin, BenchMISOPin, BenchSCLKPin ) == false ) {
+        return;
+    }
+
+    if ( TTFT_Init( &Display, BenchWidth, BenchHeight, BenchCSPin, BenchDCPin, BenchResetPin, BenchBacklightPin, TTFT_Reset_ILI9341, BenchSPIFrequency ) == false ) {
+        return;
+    }
+
+    for ( i = 0; i < 256; i++ ) {
+        TTFT_SetPaletteEntry( &Display, i, i, 255 - i, i * 4 );
+    }
+
+    /* No single colour rows, every pixel goes through the converted path */
+    for ( y = 0; y < BenchHeight; y++ ) {
+        for ( x = 0; x < BenchWidth; x++ ) {
+            Display.FrameBuffer[ ( y * BenchWidth ) + x ] = x ^ y;
+        }
+    }
+
+    TTFT_SetBacklight( &Display, true );
+
+    BenchTransport( &Display, TTFT_Transport_Polling );
+    BenchTransport( &Display, TTFT_Transport_Interrupt );
+    BenchTransport( &Display, TTFT_Transport_Queued );
+    BenchTransport( &Display, TTFT_Transport_Auto );
+
+    BenchScenarios( &Display );
+    BenchClocks( &Display );
+}
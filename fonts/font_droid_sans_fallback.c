@@ -1472,7 +1472,7 @@ const struct TTFT_FontDef Font_Droid_Sans_Fallback_11x12 = {
     11,
     12,
     ' ',
-    '\xFF',
+    '\x7F',
     false
 };
 
@@ -1482,7 +1482,7 @@ const struct TTFT_FontDef Font_Droid_Sans_Fallback_15x17 = {
     15,
     17,
     ' ',
-    '\xFF',
+    '\x7F',
     false
 };
 
@@ -1503,7 +1503,7 @@ const struct TTFT_FontDef Font_Droid_Sans_Fallback_24x25 = {
     24,
     25,
     ' ',
-    '\xFF',
+    '\x7F',
     false
 };
 
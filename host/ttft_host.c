@@ -0,0 +1,521 @@
+/**
+ * Copyright (c) 2018 Tara Keeling
+ *
+ * This software is released under the MIT License.
+ * https://opensource.org/licenses/MIT
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "ttft.h"
+#include "ttft_host.h"
+
+static void TTFT_HostPanelReset( struct TTFT_HostPanel* Panel );
+static void TTFT_HostPanelCommand( struct TTFT_HostPanel* Panel, uint8_t Command );
+static void TTFT_HostPanelParam( struct TTFT_HostPanel* Panel, uint8_t Param );
+static void TTFT_HostPanelPixel( struct TTFT_HostPanel* Panel, uint8_t Data );
+static void TTFT_HostCount( struct TTFT_HostStats* Stats, struct TTFT_HostPanel* Panel, size_t Length, int Commands );
+static bool TTFT_HostOpen( struct TTFT_Device* DeviceHandle, void* Param );
+static void TTFT_HostClose( struct TTFT_Device* DeviceHandle );
+static void TTFT_HostWrite( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t Length, bool IsCommand, bool Poll );
+static bool TTFT_HostQueue( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t Length, bool IsCommand );
+static void TTFT_HostWait( struct TTFT_Device* DeviceHandle );
+static void TTFT_HostSetReset( struct TTFT_Device* DeviceHandle, bool Level );
+
+const struct TTFT_TransportOps TTFT_HostTransport = {
+    .Open = TTFT_HostOpen,
+    .Close = TTFT_HostClose,
+    .Write = TTFT_HostWrite,
+    .Queue = TTFT_HostQueue,
+    .Wait = TTFT_HostWait,
+    .SetReset = TTFT_HostSetReset,
+    .Lock = NULL,
+    .Unlock = NULL
+};
+
+/*
+ * TTFT_HostPanelReset:
+ * Puts the decoder back the way the controller comes out of reset, GRAM is left alone.
+ */
+static void TTFT_HostPanelReset( struct TTFT_HostPanel* Panel ) {
+    Panel->Command = 0x00;
+    Panel->ParamCount = 0;
+    Panel->Col0 = 0;
+    Panel->Col1 = Panel->Width - 1;
+    Panel->Row0 = 0;
+    Panel->Row1 = Panel->Height - 1;
+    Panel->x = 0;
+    Panel->y = 0;
+    Panel->IsWriting = false;
+    Panel->PixelBytes = 0;
+    Panel->AddressMode = 0x00;
+    Panel->IsScrolling = false;
+    Panel->TopFixed = 0;
+    Panel->ScrollHeight = Panel->Height;
+    Panel->ScrollStart = 0;
+    Panel->IsPartial = false;
+    Panel->PartialStart = 0;
+    Panel->PartialEnd = Panel->Height - 1;
+
+    /* 18 bit colour until told otherwise */
+    Panel->BytesPerPixel = 3;
+}
+
+/*
+ * TTFT_HostPanelInit:
+ * Allocates a (Width) x (Height) GRAM cleared to black and puts the decoder in its reset state.
+ */
+bool TTFT_HostPanelInit( struct TTFT_HostPanel* Panel, int Width, int Height ) {
+    NullCheck( Panel, return false );
+
+    CheckBounds( Width, 1, 0xFFFF, return false );
+    CheckBounds( Height, 1, 0xFFFF, return false );
+
+    memset( Panel, 0, sizeof( struct TTFT_HostPanel ) );
+    NullCheck( ( Panel->GRAM = calloc( Width * Height, sizeof( uint32_t ) ) ), return false );
+
+    Panel->Width = Width;
+    Panel->Height = Height;
+
+    TTFT_HostPanelReset( Panel );
+    return true;
+}
+
+/*
+ * TTFT_HostPanelFree:
+ * Frees the GRAM allocated by TTFT_HostPanelInit.
+ */
+void TTFT_HostPanelFree( struct TTFT_HostPanel* Panel ) {
+    NullCheck( Panel, return );
+
+    if ( Panel->GRAM != NULL ) {
+        free( Panel->GRAM );
+    }
+
+    memset( Panel, 0, sizeof( struct TTFT_HostPanel ) );
+}
+
+/*
+ * TTFT_HostPanelGetPixel:
+ * Returns the colour at (x), (y) in GRAM or 0 if it's out of bounds.
+ */
+uint32_t TTFT_HostPanelGetPixel( struct TTFT_HostPanel* Panel, int x, int y ) {
+    NullCheck( Panel, return 0 );
+
+    CheckBounds( x, 0, Panel->Width - 1, return 0 );
+    CheckBounds( y, 0, Panel->Height - 1, return 0 );
+
+    return Panel->GRAM[ ( y * Panel->Width ) + x ];
+}
+
+/*
+ * TTFT_HostPanelCommand:
+ * Starts decoding a new command, anything left of the previous one is dropped.
+ */
+static void TTFT_HostPanelCommand( struct TTFT_HostPanel* Panel, uint8_t Command ) {
+    Panel->Command = Command;
+    Panel->ParamCount = 0;
+    Panel->PixelBytes = 0;
+    Panel->IsWriting = false;
+
+    switch ( Command ) {
+        /* Software reset */
+        case 0x01: {
+            TTFT_HostPanelReset( Panel );
+            break;
+        }
+        /* Memory write, starts over at the top left of the window */
+        case 0x2C: {
+            Panel->x = Panel->Col0;
+            Panel->y = Panel->Row0;
+            Panel->IsWriting = true;
+            break;
+        }
+        /* Memory write continue */
+        case 0x3C: {
+            Panel->IsWriting = true;
+            break;
+        }
+        /* Partial mode on, leaves scrolling */
+        case 0x12: {
+            Panel->IsPartial = true;
+            Panel->IsScrolling = false;
+            break;
+        }
+        /* Normal display mode on, leaves partial mode and scrolling */
+        case 0x13: {
+            Panel->IsPartial = false;
+            Panel->IsScrolling = false;
+            break;
+        }
+        default: break;
+    };
+}
+
+/*
+ * TTFT_HostPanelParam:
+ * Collects a parameter byte and acts on the command once it has all of them.
+ */
+static void TTFT_HostPanelParam( struct TTFT_HostPanel* Panel, uint8_t Param ) {
+    uint8_t* Params = Panel->Params;
+
+    if ( Panel->ParamCount >= TTFT_HostMaxParams ) {
+        return;
+    }
+
+    Params[ Panel->ParamCount++ ] = Param;
+
+    switch ( Panel->Command ) {
+        /* Column address set */
+        case 0x2A: {
+            if ( Panel->ParamCount == 4 ) {
+                Panel->Col0 = ( Params[ 0 ] << 8 ) | Params[ 1 ];
+                Panel->Col1 = ( Params[ 2 ] << 8 ) | Params[ 3 ];
+            }
+
+            break;
+        }
+        /* Page address set */
+        case 0x2B: {
+            if ( Panel->ParamCount == 4 ) {
+                Panel->Row0 = ( Params[ 0 ] << 8 ) | Params[ 1 ];
+                Panel->Row1 = ( Params[ 2 ] << 8 ) | Params[ 3 ];
+            }
+
+            break;
+        }
+        /* Partial area */
+        case 0x30: {
+            if ( Panel->ParamCount == 4 ) {
+                Panel->PartialStart = ( Params[ 0 ] << 8 ) | Params[ 1 ];
+                Panel->PartialEnd = ( Params[ 2 ] << 8 ) | Params[ 3 ];
+            }
+
+            break;
+        }
+        /* Vertical scrolling definition, top fixed area, scroll area and bottom fixed area */
+        case 0x33: {
+            if ( Panel->ParamCount == 6 ) {
+                Panel->TopFixed = ( Params[ 0 ] << 8 ) | Params[ 1 ];
+                Panel->ScrollHeight = ( Params[ 2 ] << 8 ) | Params[ 3 ];
+            }
+
+            break;
+        }
+        /* Memory access control */
+        case 0x36: {
+            if ( Panel->ParamCount == 1 ) {
+                Panel->AddressMode = Params[ 0 ];
+            }
+
+            break;
+        }
+        /* Vertical scrolling start address, enters scrolling mode */
+        case 0x37: {
+            if ( Panel->ParamCount == 2 ) {
+                Panel->ScrollStart = ( Params[ 0 ] << 8 ) | Params[ 1 ];
+                Panel->IsScrolling = true;
+            }
+
+            break;
+        }
+        /* Pixel format, the low bits are the MCU interface */
+        case 0x3A: {
+            if ( Panel->ParamCount == 1 ) {
+                Panel->BytesPerPixel = ( ( Params[ 0 ] & 0x07 ) == 0x05 ) ? 2 : 3;
+            }
+
+            break;
+        }
+        default: break;
+    };
+}
+
+/*
+ * TTFT_HostPanelPixel:
+ * Adds a byte of pixel data, complete pixels go into GRAM and move the write position
+ * along the window the same way the controller does.
+ */
+static void TTFT_HostPanelPixel( struct TTFT_HostPanel* Panel, uint8_t Data ) {
+    uint32_t Color = 0;
+    uint16_t Wire = 0;
+    int Columns = Panel->Width;
+    int Pages = Panel->Height;
+    int Col = Panel->x;
+    int Page = Panel->y;
+    int r = 0;
+    int g = 0;
+    int b = 0;
+
+    Panel->Pixel[ Panel->PixelBytes++ ] = Data;
+
+    if ( Panel->PixelBytes < Panel->BytesPerPixel ) {
+        return;
+    }
+
+    Panel->PixelBytes = 0;
+    Panel->Total.Pixels++;
+    Panel->Frame.Pixels++;
+
+    if ( Panel->BytesPerPixel == 2 ) {
+        Wire = ( Panel->Pixel[ 0 ] << 8 ) | Panel->Pixel[ 1 ];
+
+        r = ( Wire >> 11 ) & 0x1F;
+        g = ( Wire >> 5 ) & 0x3F;
+        b = Wire & 0x1F;
+
+        r = ( r << 3 ) | ( r >> 2 );
+        g = ( g << 2 ) | ( g >> 4 );
+        b = ( b << 3 ) | ( b >> 2 );
+    }
+    else {
+        r = ( Panel->Pixel[ 0 ] & 0xFC ) | ( Panel->Pixel[ 0 ] >> 6 );
+        g = ( Panel->Pixel[ 1 ] & 0xFC ) | ( Panel->Pixel[ 1 ] >> 6 );
+        b = ( Panel->Pixel[ 2 ] & 0xFC ) | ( Panel->Pixel[ 2 ] >> 6 );
+    }
+
+    Color = ( Panel->AddressMode & MADCTL_BGR ) ? ( ( b << 16 ) | ( g << 8 ) | r ) : ( ( r << 16 ) | ( g << 8 ) | b );
+
+    if ( Panel->AddressMode & MADCTL_MV ) {
+        Columns = Panel->Height;
+        Pages = Panel->Width;
+    }
+
+    /* Mirror the addresses, then exchange them onto GRAM */
+    if ( Col < Columns && Page < Pages ) {
+        Col = ( Panel->AddressMode & MADCTL_MX ) ? ( Columns - 1 ) - Col : Col;
+        Page = ( Panel->AddressMode & MADCTL_MY ) ? ( Pages - 1 ) - Page : Page;
+
+        if ( Panel->AddressMode & MADCTL_MV ) {
+            Panel->GRAM[ ( Col * Panel->Width ) + Page ] = Color;
+        }
+        else {
+            Panel->GRAM[ ( Page * Panel->Width ) + Col ] = Color;
+        }
+    }
+
+    if ( ++Panel->x > Panel->Col1 ) {
+        Panel->x = Panel->Col0;
+
+        if ( ++Panel->y > Panel->Row1 ) {
+            Panel->y = Panel->Row0;
+        }
+    }
+}
+
+/*
+ * TTFT_HostPanelWrite:
+ * Feeds (Length) bytes to the decoder as a command or data, what TTFT_HostTransport does for every write.
+ */
+void TTFT_HostPanelWrite( struct TTFT_HostPanel* Panel, const uint8_t* Data, size_t Length, bool IsCommand ) {
+    size_t i = 0;
+
+    NullCheck( Panel, return );
+    NullCheck( Data, return );
+
+    TTFT_HostCount( &Panel->Total, Panel, Length, ( IsCommand == true ) ? Length : 0 );
+    TTFT_HostCount( &Panel->Frame, Panel, Length, ( IsCommand == true ) ? Length : 0 );
+
+    if ( Panel->Capture != NULL ) {
+        fputc( ( IsCommand == true ) ? 'C' : 'D', Panel->Capture );
+
+        for ( i = 0; i < Length; i++ ) {
+            fprintf( Panel->Capture, " %02X", Data[ i ] );
+        }
+
+        fputc( '\n', Panel->Capture );
+    }
+
+    for ( i = 0; i < Length; i++ ) {
+        if ( IsCommand == true ) {
+            TTFT_HostPanelCommand( Panel, Data[ i ] );
+        }
+        else if ( Panel->IsWriting == true ) {
+            TTFT_HostPanelPixel( Panel, Data[ i ] );
+        }
+        else {
+            TTFT_HostPanelParam( Panel, Data[ i ] );
+        }
+    }
+}
+
+/*
+ * TTFT_HostCount:
+ * Adds a transfer of (Length) bytes to (Stats).
+ */
+static void TTFT_HostCount( struct TTFT_HostStats* Stats, struct TTFT_HostPanel* Panel, size_t Length, int Commands ) {
+    Stats->Commands+= Commands;
+    Stats->Transfers++;
+    Stats->Bytes+= Length;
+
+    if ( Panel->Frequency > 0 ) {
+        Stats->WireTimeNs+= ( ( uint64_t ) Length * 8000000000ULL ) / Panel->Frequency;
+        Stats->WireTimeNs+= Panel->TransferOverheadNs;
+    }
+}
+
+/*
+ * TTFT_HostPanelEndFrame:
+ * Copies the traffic since the last call into (Stats) if it's not NULL and starts counting the next frame.
+ */
+void TTFT_HostPanelEndFrame( struct TTFT_HostPanel* Panel, struct TTFT_HostStats* Stats ) {
+    NullCheck( Panel, return );
+
+    if ( Stats != NULL ) {
+        memcpy( Stats, &Panel->Frame, sizeof( struct TTFT_HostStats ) );
+    }
+
+    memset( &Panel->Frame, 0, sizeof( struct TTFT_HostStats ) );
+}
+
+/*
+ * TTFT_HostPanelRender:
+ * Fills (Frame) with the (Width) x (Height) image the panel would be showing,
+ * which is GRAM with the scroll and partial areas applied.
+ */
+void TTFT_HostPanelRender( struct TTFT_HostPanel* Panel, uint32_t* Frame ) {
+    int ScrollEnd = 0;
+    int Source = 0;
+    int y = 0;
+
+    NullCheck( Panel, return );
+    NullCheck( Frame, return );
+
+    ScrollEnd = Panel->TopFixed + Panel->ScrollHeight;
+
+    for ( y = 0; y < Panel->Height; y++ ) {
+        Source = y;
+
+        /* Lines in the scroll area start at the scroll start address and wrap within it */
+        if ( Panel->IsScrolling == true && Panel->ScrollHeight > 0 && y >= Panel->TopFixed && y < ScrollEnd ) {
+            Source = Panel->ScrollStart + ( y - Panel->TopFixed );
+            Source = Panel->TopFixed + ( ( ( Source - Panel->TopFixed ) % Panel->ScrollHeight ) + Panel->ScrollHeight ) % Panel->ScrollHeight;
+            Source = ( Source < Panel->Height ) ? Source : y;
+        }
+
+        /* Outside of the partial area is the non display colour, which is black */
+        if ( Panel->IsPartial == true && ( y < Panel->PartialStart || y > Panel->PartialEnd ) ) {
+            memset( &Frame[ y * Panel->Width ], 0, Panel->Width * sizeof( uint32_t ) );
+        }
+        else {
+            memcpy( &Frame[ y * Panel->Width ], &Panel->GRAM[ Source * Panel->Width ], Panel->Width * sizeof( uint32_t ) );
+        }
+    }
+}
+
+/*
+ * TTFT_InitHost:
+ * Same as TTFT_InitEx for a display decoded into (Panel), which must have been set up with TTFT_HostPanelInit.
+ */
+bool TTFT_InitHost( struct TTFT_Device* DeviceHandle, int Width, int Height, struct TTFT_HostPanel* Panel, void ( *ResetProc ) ( struct TTFT_Device* ), int Flags ) {
+    return TTFT_InitTransport( DeviceHandle, Width, Height, -1, &TTFT_HostTransport, Panel, ResetProc, Flags );
+}
+
+/*
+ * TTFT_HostOpen:
+ * Attaches the device to the struct TTFT_HostPanel in (Param), which must have been set up with TTFT_HostPanelInit.
+ */
+static bool TTFT_HostOpen( struct TTFT_Device* DeviceHandle, void* Param ) {
+    struct TTFT_HostPanel* Panel = ( struct TTFT_HostPanel* ) Param;
+
+    NullCheck( Panel, return false );
+    NullCheck( Panel->GRAM, return false );
+
+    Panel->QueueHead = 0;
+    Panel->QueueCount = 0;
+
+    DeviceHandle->TransportState = Panel;
+    return true;
+}
+
+/*
+ * TTFT_HostClose:
+ * Detaches the device from its panel, writes still queued are dropped.
+ */
+static void TTFT_HostClose( struct TTFT_Device* DeviceHandle ) {
+    struct TTFT_HostPanel* Panel = ( struct TTFT_HostPanel* ) DeviceHandle->TransportState;
+
+    /* Anything still queued never made it out, the panel belongs to the caller */
+    if ( Panel != NULL ) {
+        Panel->QueueCount = 0;
+    }
+
+    DeviceHandle->TransportState = NULL;
+}
+
+/*
+ * TTFT_HostWrite:
+ * Decodes a write straight away, (Poll) makes no difference here.
+ */
+static void TTFT_HostWrite( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t Length, bool IsCommand, bool Poll ) {
+    struct TTFT_HostPanel* Panel = ( struct TTFT_HostPanel* ) DeviceHandle->TransportState;
+
+    /* The SPI driver doesn't allow this, finish the queue first so the order is still right */
+    if ( Panel->QueueCount > 0 ) {
+        ESP_LOGE( __FUNCTION__, "Write with %d transfers still queued", Panel->QueueCount );
+
+        while ( Panel->QueueCount > 0 ) {
+            TTFT_HostWait( DeviceHandle );
+        }
+    }
+
+    TTFT_HostPanelWrite( Panel, Data, Length, IsCommand );
+}
+
+/*
+ * TTFT_HostQueue:
+ * Keeps a pointer to a write until TTFT_HostWait decodes it.
+ * Returns false if TTFT_HostMaxQueued writes are already waiting.
+ */
+static bool TTFT_HostQueue( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t Length, bool IsCommand ) {
+    struct TTFT_HostPanel* Panel = ( struct TTFT_HostPanel* ) DeviceHandle->TransportState;
+    struct TTFT_HostQueued* Queued = NULL;
+
+    if ( Panel->QueueCount >= TTFT_HostMaxQueued ) {
+        ESP_LOGE( __FUNCTION__, "Queue is full" );
+        return false;
+    }
+
+    Queued = &Panel->Queue[ ( Panel->QueueHead + Panel->QueueCount ) % TTFT_HostMaxQueued ];
+    Queued->Data = Data;
+    Queued->Length = Length;
+    Queued->IsCommand = IsCommand;
+
+    Panel->QueueCount++;
+    return true;
+}
+
+/*
+ * TTFT_HostWait:
+ * Decodes the oldest queued write, as if its transfer just finished.
+ */
+static void TTFT_HostWait( struct TTFT_Device* DeviceHandle ) {
+    struct TTFT_HostPanel* Panel = ( struct TTFT_HostPanel* ) DeviceHandle->TransportState;
+    struct TTFT_HostQueued* Queued = NULL;
+
+    if ( Panel->QueueCount == 0 ) {
+        ESP_LOGE( __FUNCTION__, "Nothing queued" );
+        return;
+    }
+
+    Queued = &Panel->Queue[ Panel->QueueHead ];
+
+    Panel->QueueHead = ( Panel->QueueHead + 1 ) % TTFT_HostMaxQueued;
+    Panel->QueueCount--;
+
+    TTFT_HostPanelWrite( Panel, Queued->Data, Queued->Length, Queued->IsCommand );
+}
+
+/*
+ * TTFT_HostSetReset:
+ * Holding reset low puts the panel's decoder back in its reset state, GRAM is kept.
+ */
+static void TTFT_HostSetReset( struct TTFT_Device* DeviceHandle, bool Level ) {
+    if ( Level == false ) {
+        TTFT_HostPanelReset( ( struct TTFT_HostPanel* ) DeviceHandle->TransportState );
+    }
+}
@@ -0,0 +1,175 @@
+#ifndef _TTFT_HOST_H_
+#define _TTFT_HOST_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct TTFT_Device;
+struct TTFT_TransportOps;
+
+/* Longest parameter list the decoder keeps */
+#define TTFT_HostMaxParams 16
+
+/* Writes TTFT_HostTransport holds on to until they're waited for, the same as TTFT_TransportQueueDepth */
+#define TTFT_HostMaxQueued 8
+
+/*
+ * A write queued through TTFT_HostTransport.
+ * Only the pointer is kept, like a DMA transfer the data is read when it's decoded.
+ */
+struct TTFT_HostQueued {
+    const uint8_t* Data;
+    size_t Length;
+    bool IsCommand;
+};
+
+/*
+ * Traffic seen by a struct TTFT_HostPanel.
+ * (WireTimeNs) is how long the bytes would take at the panel's (Frequency) plus
+ * (TransferOverheadNs) for each transfer, it stays 0 if no frequency was set.
+ */
+struct TTFT_HostStats {
+    uint32_t Commands;
+    uint32_t Transfers;
+    uint32_t Bytes;
+    uint32_t Pixels;
+    uint64_t WireTimeNs;
+};
+
+/*
+ * Emulated ILI9341/ST7735 style controller for TTFT_HostTransport.
+ * Commands are decoded as they arrive and pixels end up in GRAM as 24 bit RGB,
+ * the same layout as Color_t, with the low bits filled in from the high ones.
+ *
+ * (Width) and (Height) are the size of GRAM in the controller's native orientation,
+ * MADCTL maps the column and page addresses onto it the same way the controller does.
+ * Vertical scrolling and partial mode only change what TTFT_HostPanelRender shows, not GRAM.
+ */
+struct TTFT_HostPanel {
+    int Width;
+    int Height;
+    uint32_t* GRAM;
+
+    /* SPI clock and fixed cost of each transfer used for WireTimeNs, set these after TTFT_HostPanelInit */
+    int Frequency;
+    uint32_t TransferOverheadNs;
+
+    /* Command being decoded and the parameters seen so far */
+    uint8_t Command;
+    uint8_t Params[ TTFT_HostMaxParams ];
+    int ParamCount;
+
+    /* Address window from CASET/RASET and where the next pixel goes */
+    int Col0;
+    int Col1;
+    int Row0;
+    int Row1;
+    int x;
+    int y;
+
+    /* Set by RAMWR, data is pixels until the next command */
+    bool IsWriting;
+    int BytesPerPixel;
+    uint8_t Pixel[ 3 ];
+    int PixelBytes;
+
+    /* Last MADCTL value */
+    uint8_t AddressMode;
+
+    /* Vertical scrolling from VSCRDEF and VSCRSADD */
+    bool IsScrolling;
+    int TopFixed;
+    int ScrollHeight;
+    int ScrollStart;
+
+    /* Partial area from PTLAR */
+    bool IsPartial;
+    int PartialStart;
+    int PartialEnd;
+
+    /* Totals since TTFT_HostPanelInit and since the last TTFT_HostPanelEndFrame */
+    struct TTFT_HostStats Total;
+    struct TTFT_HostStats Frame;
+
+    /* If not NULL every transfer is logged here as text, one line each */
+    FILE* Capture;
+
+    /* Queued writes not decoded yet, oldest at (QueueHead) */
+    struct TTFT_HostQueued Queue[ TTFT_HostMaxQueued ];
+    int QueueHead;
+    int QueueCount;
+};
+
+/*
+ * TTFT_HostPanelInit:
+ * Allocates a (Width) x (Height) GRAM cleared to black and puts the decoder in its reset state.
+ */
+bool TTFT_HostPanelInit( struct TTFT_HostPanel* Panel, int Width, int Height );
+
+/*
+ * TTFT_HostPanelFree:
+ * Frees the GRAM allocated by TTFT_HostPanelInit.
+ */
+void TTFT_HostPanelFree( struct TTFT_HostPanel* Panel );
+
+/*
+ * TTFT_HostPanelGetPixel:
+ * Returns the colour at (x), (y) in GRAM or 0 if it's out of bounds.
+ */
+uint32_t TTFT_HostPanelGetPixel( struct TTFT_HostPanel* Panel, int x, int y );
+
+/*
+ * TTFT_HostPanelWrite:
+ * Feeds (Length) bytes to the decoder as a command or data, what TTFT_HostTransport does for every write.
+ */
+void TTFT_HostPanelWrite( struct TTFT_HostPanel* Panel, const uint8_t* Data, size_t Length, bool IsCommand );
+
+/*
+ * TTFT_HostPanelEndFrame:
+ * Copies the traffic since the last call into (Stats) if it's not NULL and starts counting the next frame.
+ */
+void TTFT_HostPanelEndFrame( struct TTFT_HostPanel* Panel, struct TTFT_HostStats* Stats );
+
+/*
+ * TTFT_HostPanelRender:
+ * Fills (Frame) with the (Width) x (Height) image the panel would be showing,
+ * which is GRAM with the scroll and partial areas applied.
+ */
+void TTFT_HostPanelRender( struct TTFT_HostPanel* Panel, uint32_t* Frame );
+
+/*
+ * TTFT_HostPanelSavePPM:
+ * Writes what the panel is showing to (Path) as a binary PPM.
+ */
+bool TTFT_HostPanelSavePPM( struct TTFT_HostPanel* Panel, const char* Path );
+
+/*
+ * TTFT_HostPanelSavePNG:
+ * Writes what the panel is showing to (Path) as an uncompressed PNG.
+ */
+bool TTFT_HostPanelSavePNG( struct TTFT_HostPanel* Panel, const char* Path );
+
+/*
+ * TTFT_InitHost:
+ * Same as TTFT_InitEx for a display decoded into (Panel), which must have been set up with TTFT_HostPanelInit.
+ */
+bool TTFT_InitHost( struct TTFT_Device* DeviceHandle, int Width, int Height, struct TTFT_HostPanel* Panel, void ( *ResetProc ) ( struct TTFT_Device* ), int Flags );
+
+/*
+ * Transport that decodes everything into a struct TTFT_HostPanel, passed as the Param to TTFT_InitTransport.
+ * Writes are decoded before they return, queued ones only when they're waited for
+ * so a buffer reused too early shows up in GRAM the same way it would on the display.
+ */
+extern const struct TTFT_TransportOps TTFT_HostTransport;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
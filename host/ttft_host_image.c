@@ -0,0 +1,242 @@
+/**
+ * Copyright (c) 2018 Tara Keeling
+ *
+ * This software is released under the MIT License.
+ * https://opensource.org/licenses/MIT
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "ttft.h"
+#include "ttft_host.h"
+
+/* Most bytes a stored deflate block can hold */
+#define PNGStoredBlockMax 65535
+
+static uint32_t* TTFT_HostRenderCopy( struct TTFT_HostPanel* Panel );
+static uint32_t TTFT_PNGCRC( uint32_t CRC, const uint8_t* Data, size_t Length );
+static void TTFT_PNGWrite( FILE* fp, uint32_t* CRC, const uint8_t* Data, size_t Length );
+static void TTFT_PNGWrite32( FILE* fp, uint32_t* CRC, uint32_t Value );
+static void TTFT_PNGChunk( FILE* fp, const char* Type, const uint8_t* Data, uint32_t Length );
+
+/*
+ * TTFT_HostRenderCopy:
+ * Returns a newly allocated copy of what the panel is showing, free it when done.
+ */
+static uint32_t* TTFT_HostRenderCopy( struct TTFT_HostPanel* Panel ) {
+    uint32_t* Frame = NULL;
+
+    NullCheck( ( Frame = malloc( Panel->Width * Panel->Height * sizeof( uint32_t ) ) ), return NULL );
+    TTFT_HostPanelRender( Panel, Frame );
+
+    return Frame;
+}
+
+/*
+ * TTFT_HostPanelSavePPM:
+ * Writes what the panel is showing to (Path) as a binary PPM.
+ */
+bool TTFT_HostPanelSavePPM( struct TTFT_HostPanel* Panel, const char* Path ) {
+    uint32_t* Frame = NULL;
+    uint8_t RGB[ 3 ];
+    FILE* fp = NULL;
+    int i = 0;
+
+    NullCheck( Panel, return false );
+    NullCheck( Path, return false );
+
+    NullCheck( ( Frame = TTFT_HostRenderCopy( Panel ) ), return false );
+    NullCheck( ( fp = fopen( Path, "wb" ) ), free( Frame ); return false );
+
+    fprintf( fp, "P6\n%d %d\n255\n", Panel->Width, Panel->Height );
+
+    for ( i = 0; i < Panel->Width * Panel->Height; i++ ) {
+        RGB[ 0 ] = ( Frame[ i ] >> 16 ) & 0xFF;
+        RGB[ 1 ] = ( Frame[ i ] >> 8 ) & 0xFF;
+        RGB[ 2 ] = Frame[ i ] & 0xFF;
+
+        fwrite( RGB, 1, sizeof( RGB ), fp );
+    }
+
+    fclose( fp );
+    free( Frame );
+
+    return true;
+}
+
+/*
+ * TTFT_PNGCRC:
+ * Continues the PNG chunk CRC over (Length) more bytes, start with 0.
+ */
+static uint32_t TTFT_PNGCRC( uint32_t CRC, const uint8_t* Data, size_t Length ) {
+    static uint32_t Table[ 256 ];
+    static bool HaveTable = false;
+    uint32_t c = 0;
+    size_t i = 0;
+    int k = 0;
+
+    if ( HaveTable == false ) {
+        for ( i = 0; i < 256; i++ ) {
+            for ( c = i, k = 0; k < 8; k++ ) {
+                c = ( c & 1 ) ? 0xEDB88320 ^ ( c >> 1 ) : c >> 1;
+            }
+
+            Table[ i ] = c;
+        }
+
+        HaveTable = true;
+    }
+
+    for ( CRC = ~CRC, i = 0; i < Length; i++ ) {
+        CRC = Table[ ( CRC ^ Data[ i ] ) & 0xFF ] ^ ( CRC >> 8 );
+    }
+
+    return ~CRC;
+}
+
+/*
+ * TTFT_PNGWrite:
+ * Writes (Length) bytes of chunk data and adds them to the chunk's CRC.
+ */
+static void TTFT_PNGWrite( FILE* fp, uint32_t* CRC, const uint8_t* Data, size_t Length ) {
+    if ( Length > 0 ) {
+        fwrite( Data, 1, Length, fp );
+        *CRC = TTFT_PNGCRC( *CRC, Data, Length );
+    }
+}
+
+/*
+ * TTFT_PNGWrite32:
+ * Writes (Value) big endian, PNG byte order.
+ */
+static void TTFT_PNGWrite32( FILE* fp, uint32_t* CRC, uint32_t Value ) {
+    uint8_t Data[ 4 ] = {
+        ( Value >> 24 ) & 0xFF,
+        ( Value >> 16 ) & 0xFF,
+        ( Value >> 8 ) & 0xFF,
+        Value & 0xFF
+    };
+
+    TTFT_PNGWrite( fp, CRC, Data, sizeof( Data ) );
+}
+
+/*
+ * TTFT_PNGChunk:
+ * Writes a whole chunk that's already in memory.
+ */
+static void TTFT_PNGChunk( FILE* fp, const char* Type, const uint8_t* Data, uint32_t Length ) {
+    uint32_t CRC = 0;
+
+    TTFT_PNGWrite32( fp, &CRC, Length );
+
+    CRC = 0;
+    TTFT_PNGWrite( fp, &CRC, ( const uint8_t* ) Type, 4 );
+    TTFT_PNGWrite( fp, &CRC, Data, Length );
+
+    TTFT_PNGWrite32( fp, &CRC, CRC );
+}
+
+/*
+ * TTFT_HostPanelSavePNG:
+ * Writes what the panel is showing to (Path) as an uncompressed PNG.
+ *
+ * Pixel data goes in stored deflate blocks so no zlib is needed, the files are
+ * about the size of a PPM but open anywhere.
+ */
+bool TTFT_HostPanelSavePNG( struct TTFT_HostPanel* Panel, const char* Path ) {
+    static const uint8_t Signature[ ] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+    static const uint8_t ZlibHeader[ ] = { 0x78, 0x01 };
+    uint32_t* Frame = NULL;
+    uint8_t* Raw = NULL;
+    uint8_t* Out = NULL;
+    uint8_t Header[ 13 ];
+    uint8_t Block[ 5 ];
+    uint32_t Adler1 = 1;
+    uint32_t Adler2 = 0;
+    uint32_t CRC = 0;
+    size_t RawSize = 0;
+    size_t Blocks = 0;
+    size_t Offset = 0;
+    size_t Length = 0;
+    size_t i = 0;
+    FILE* fp = NULL;
+    int x = 0;
+    int y = 0;
+
+    NullCheck( Panel, return false );
+    NullCheck( Path, return false );
+
+    /* Each row is a filter type byte (none) followed by RGB */
+    RawSize = ( size_t ) Panel->Height * ( 1 + ( Panel->Width * 3 ) );
+    Blocks = ( RawSize + PNGStoredBlockMax - 1 ) / PNGStoredBlockMax;
+
+    NullCheck( ( Frame = TTFT_HostRenderCopy( Panel ) ), return false );
+    NullCheck( ( Raw = malloc( RawSize ) ), free( Frame ); return false );
+
+    for ( Out = Raw, y = 0; y < Panel->Height; y++ ) {
+        *Out++ = 0;
+
+        for ( x = 0; x < Panel->Width; x++ ) {
+            *Out++ = ( Frame[ ( y * Panel->Width ) + x ] >> 16 ) & 0xFF;
+            *Out++ = ( Frame[ ( y * Panel->Width ) + x ] >> 8 ) & 0xFF;
+            *Out++ = Frame[ ( y * Panel->Width ) + x ] & 0xFF;
+        }
+    }
+
+    free( Frame );
+
+    for ( i = 0; i < RawSize; i++ ) {
+        Adler1 = ( Adler1 + Raw[ i ] ) % 65521;
+        Adler2 = ( Adler2 + Adler1 ) % 65521;
+    }
+
+    NullCheck( ( fp = fopen( Path, "wb" ) ), free( Raw ); return false );
+
+    fwrite( Signature, 1, sizeof( Signature ), fp );
+
+    /* Width, height, 8 bits per channel, truecolour, deflate, no filtering, no interlace */
+    memset( Header, 0, sizeof( Header ) );
+
+    Header[ 2 ] = ( Panel->Width >> 8 ) & 0xFF;
+    Header[ 3 ] = Panel->Width & 0xFF;
+    Header[ 6 ] = ( Panel->Height >> 8 ) & 0xFF;
+    Header[ 7 ] = Panel->Height & 0xFF;
+    Header[ 8 ] = 8;
+    Header[ 9 ] = 2;
+
+    TTFT_PNGChunk( fp, "IHDR", Header, sizeof( Header ) );
+
+    /* IDAT is written in pieces, the length is known up front */
+    TTFT_PNGWrite32( fp, &CRC, sizeof( ZlibHeader ) + ( Blocks * sizeof( Block ) ) + RawSize + 4 );
+
+    CRC = 0;
+    TTFT_PNGWrite( fp, &CRC, ( const uint8_t* ) "IDAT", 4 );
+    TTFT_PNGWrite( fp, &CRC, ZlibHeader, sizeof( ZlibHeader ) );
+
+    for ( Offset = 0; Offset < RawSize; Offset+= Length ) {
+        Length = ( RawSize - Offset > PNGStoredBlockMax ) ? PNGStoredBlockMax : RawSize - Offset;
+
+        Block[ 0 ] = ( Offset + Length == RawSize ) ? 1 : 0;
+        Block[ 1 ] = Length & 0xFF;
+        Block[ 2 ] = ( Length >> 8 ) & 0xFF;
+        Block[ 3 ] = ~Length & 0xFF;
+        Block[ 4 ] = ( ~Length >> 8 ) & 0xFF;
+
+        TTFT_PNGWrite( fp, &CRC, Block, sizeof( Block ) );
+        TTFT_PNGWrite( fp, &CRC, &Raw[ Offset ], Length );
+    }
+
+    TTFT_PNGWrite32( fp, &CRC, ( Adler2 << 16 ) | Adler1 );
+    TTFT_PNGWrite32( fp, &CRC, CRC );
+
+    TTFT_PNGChunk( fp, "IEND", NULL, 0 );
+
+    fclose( fp );
+    free( Raw );
+
+    return true;
+}
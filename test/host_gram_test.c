@@ -0,0 +1,323 @@
+/**
+ * Copyright (c) 2018 Tara Keeling
+ *
+ * This software is released under the MIT License.
+ * https://opensource.org/licenses/MIT
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_sleep.h"
+#include "ttft.h"
+#include "ttft_font.h"
+#include "ttft_host.h"
+
+/*
+ * Draws through TTFT_HostTransport and checks that what ended up in the emulated
+ * controller's GRAM is the framebuffer run through the palette and pixel format.
+ *
+ * Covers both pixel formats, polled and queued updates, solid runs,
+ * partial mode with and without MADCTL_MV and resuming after TTFT_Sleep.
+ * Exits with 0 if every case passes.
+ */
+
+#define PanelWidth 240
+#define PanelHeight 320
+
+/* Rows of the panel driven in the partial mode cases */
+#define PartialY0 100
+#define PartialY1 199
+
+struct TestCase {
+    const char* Name;
+    int Flags;
+    TTFT_Transport Transport;
+    bool IsExchanged;
+    bool IsResumed;
+};
+
+static const struct TestCase TestCases[ ] = {
+    { "rgb565_auto", TTFT_InitFlag_Default, TTFT_Transport_Auto, false, false },
+    { "rgb565_queued", TTFT_InitFlag_Default, TTFT_Transport_Queued, false, false },
+    { "rgb666_auto", TTFT_InitFlag_RGB666, TTFT_Transport_Auto, false, false },
+    { "rgb666_queued", TTFT_InitFlag_RGB666, TTFT_Transport_Queued, false, false },
+    { "rgb565_exchanged", TTFT_InitFlag_Default, TTFT_Transport_Queued, true, false },
+    { "rgb666_exchanged", TTFT_InitFlag_RGB666, TTFT_Transport_Auto, true, false },
+    { "rgb565_resumed", TTFT_InitFlag_Default, TTFT_Transport_Auto, false, true },
+    { "rgb666_resumed", TTFT_InitFlag_RGB666, TTFT_Transport_Queued, false, true },
+    { "rgb565_exchanged_resumed", TTFT_InitFlag_Default, TTFT_Transport_Auto, true, true },
+    { "rgb666_exchanged_resumed", TTFT_InitFlag_RGB666, TTFT_Transport_Queued, true, true }
+};
+
+/*
+ * ExpectedColor:
+ * What the panel stores for (Color) after it went over the wire in (Format).
+ */
+static uint32_t ExpectedColor( TTFT_PixelFormat Format, Color_t Color ) {
+    uint32_t r = ( Color >> 16 ) & 0xFF;
+    uint32_t g = ( Color >> 8 ) & 0xFF;
+    uint32_t b = Color & 0xFF;
+
+    if ( Format == TTFT_PixelFormat_RGB666 ) {
+        r = ( r & 0xFC ) | ( r >> 6 );
+        g = ( g & 0xFC ) | ( g >> 6 );
+        b = ( b & 0xFC ) | ( b >> 6 );
+    }
+    else {
+        r = ( ( r >> 3 ) << 3 ) | ( r >> 5 );
+        g = ( ( g >> 2 ) << 2 ) | ( g >> 6 );
+        b = ( ( b >> 3 ) << 3 ) | ( b >> 5 );
+    }
+
+    return ( r << 16 ) | ( g << 8 ) | b;
+}
+
+/*
+ * SetPalette:
+ * Fills the palette with colours that are all different after quantizing.
+ */
+static void SetPalette( struct TTFT_Device* DeviceHandle ) {
+    int i = 0;
+
+    for ( i = 0; i < 255; i++ ) {
+        TTFT_SetPaletteEntry( DeviceHandle, i, i * 37, 255 - i, i * 5 );
+    }
+}
+
+/*
+ * DrawScene:
+ * Fills the framebuffer with a mix of noisy pixels, which go through the row converters,
+ * large single colour areas, which are sent as solid runs, and text.
+ * (Seed) changes every colour so one scene can be told from another.
+ */
+static void DrawScene( struct TTFT_Device* DeviceHandle, int Seed ) {
+    int Width = DeviceHandle->Width;
+    int Height = DeviceHandle->Height;
+    int x = 0;
+    int y = 0;
+
+    for ( y = 0; y < Height; y++ ) {
+        for ( x = 0; x < Width; x++ ) {
+            TTFT_PutPixel( DeviceHandle, x, y, ( ( x * 7 ) + ( y * 13 ) + Seed ) % 255 );
+        }
+    }
+
+    TTFT_FillRect( DeviceHandle, 0, 0, Width - 1, ( Height / 4 ) - 1, ( Seed + 11 ) % 255 );
+    TTFT_FillRect( DeviceHandle, 0, Height / 2, ( Width / 2 ) - 1, Height - 1, ( Seed + 97 ) % 255 );
+    TTFT_DrawBox( DeviceHandle, 4, 4, Width - 5, Height - 5, 3, ( Seed + 200 ) % 255 );
+
+    TTFT_SetFont( DeviceHandle, &Font_Char_16x22 );
+    TTFT_FontDrawString( DeviceHandle, 10, ( Height / 4 ) + 10, ( Seed + 1 ) % 255, ( Seed + 2 ) % 255, "GRAM 0123" );
+}
+
+/*
+ * GetGRAMPixel:
+ * Returns the panel's pixel for framebuffer pixel (x), (y).
+ * With MADCTL_MV the framebuffer's columns are the panel's rows.
+ */
+static uint32_t GetGRAMPixel( struct TTFT_HostPanel* Panel, bool IsExchanged, int x, int y ) {
+    return ( IsExchanged == true ) ? TTFT_HostPanelGetPixel( Panel, y, x ) : TTFT_HostPanelGetPixel( Panel, x, y );
+}
+
+/*
+ * CheckGRAM:
+ * Compares GRAM with (Expected), which holds a colour for every framebuffer pixel.
+ * Returns the number of pixels that differ and prints the first one.
+ */
+static int CheckGRAM( const struct TestCase* Case, const char* Step, struct TTFT_Device* DeviceHandle, struct TTFT_HostPanel* Panel, const uint32_t* Expected ) {
+    uint32_t Actual = 0;
+    int Mismatches = 0;
+    int x = 0;
+    int y = 0;
+
+    for ( y = 0; y < DeviceHandle->Height; y++ ) {
+        for ( x = 0; x < DeviceHandle->Width; x++ ) {
+            Actual = GetGRAMPixel( Panel, Case->IsExchanged, x, y );
+
+            if ( Actual != Expected[ ( y * DeviceHandle->Width ) + x ] ) {
+                if ( Mismatches++ == 0 ) {
+                    printf( "%s %s: pixel %d,%d is %06X, expected %06X\n", Case->Name, Step, x, y, ( unsigned ) Actual, ( unsigned ) Expected[ ( y * DeviceHandle->Width ) + x ] );
+                }
+            }
+        }
+    }
+
+    return Mismatches;
+}
+
+/*
+ * SnapshotFrameBuffer:
+ * Sets (Expected) to what every pixel of the framebuffer should look like on the panel.
+ * With (IsPartial) only pixels on the driven rows of the panel are replaced.
+ * The pixel format comes from the case, not the device, so one the device forgot shows up as a mismatch.
+ */
+static void SnapshotFrameBuffer( const struct TestCase* Case, struct TTFT_Device* DeviceHandle, uint32_t* Expected, bool IsPartial ) {
+    TTFT_PixelFormat Format = ( Case->Flags & TTFT_InitFlag_RGB666 ) ? TTFT_PixelFormat_RGB666 : TTFT_PixelFormat_RGB565;
+    int NativeRow = 0;
+    int x = 0;
+    int y = 0;
+
+    for ( y = 0; y < DeviceHandle->Height; y++ ) {
+        for ( x = 0; x < DeviceHandle->Width; x++ ) {
+            NativeRow = ( Case->IsExchanged == true ) ? x : y;
+
+            if ( IsPartial == true && ( NativeRow < PartialY0 || NativeRow > PartialY1 ) ) {
+                continue;
+            }
+
+            Expected[ ( y * DeviceHandle->Width ) + x ] = ExpectedColor( Format, DeviceHandle->Palette[ DeviceHandle->FrameBuffer[ ( y * DeviceHandle->Width ) + x ] ] );
+        }
+    }
+}
+
+/*
+ * CheckPartial:
+ * Draws a new scene in partial mode and checks only the driven rows changed,
+ * then leaves partial mode and checks everything came back.
+ * Returns the number of mismatched pixels.
+ */
+static int CheckPartial( const struct TestCase* Case, const char* Step, struct TTFT_Device* DeviceHandle, struct TTFT_HostPanel* Panel, uint32_t* Expected, int Seed ) {
+    char StepName[ 64 ];
+    int Mismatches = 0;
+
+    /* Only the driven rows should be sent, the rest of GRAM keeps the last scene */
+    TTFT_SetPartialArea( DeviceHandle, PartialY0, PartialY1 );
+    DrawScene( DeviceHandle, Seed );
+    TTFT_Update( DeviceHandle );
+
+    snprintf( StepName, sizeof( StepName ), "%s partial", Step );
+    SnapshotFrameBuffer( Case, DeviceHandle, Expected, true );
+    Mismatches+= CheckGRAM( Case, StepName, DeviceHandle, Panel, Expected );
+
+    /* Everything comes back once partial mode is off */
+    TTFT_ClearPartialArea( DeviceHandle );
+    TTFT_Update( DeviceHandle );
+
+    snprintf( StepName, sizeof( StepName ), "%s cleared", Step );
+    SnapshotFrameBuffer( Case, DeviceHandle, Expected, false );
+    Mismatches+= CheckGRAM( Case, StepName, DeviceHandle, Panel, Expected );
+
+    return Mismatches;
+}
+
+/*
+ * CheckResume:
+ * Puts the display to sleep and brings it back with TTFT_InitFlag_Resume as if waking from deep sleep,
+ * without TTFT_InitFlag_RGB666 so the pixel format has to come from before sleeping.
+ * Then draws, updates and checks the same way as before sleeping.
+ * Returns the number of mismatched pixels, or 1 if the display was not resumed.
+ */
+static int CheckResume( const struct TestCase* Case, struct TTFT_Device* DeviceHandle, struct TTFT_HostPanel* Panel, uint32_t* Expected ) {
+    int Width = DeviceHandle->Width;
+    int Height = DeviceHandle->Height;
+    int Mismatches = 0;
+    bool IsResumed = false;
+
+    TTFT_Sleep( DeviceHandle );
+    TTFT_DeInit( DeviceHandle );
+
+    HostSetWakeupCause( ESP_SLEEP_WAKEUP_TIMER );
+    IsResumed = TTFT_InitHost( DeviceHandle, Width, Height, Panel, TTFT_Reset_ILI9341, TTFT_InitFlag_Resume ) && TTFT_IsResumed( DeviceHandle );
+    HostSetWakeupCause( ESP_SLEEP_WAKEUP_UNDEFINED );
+
+    if ( IsResumed == false ) {
+        printf( "%s: display was not resumed\n", Case->Name );
+        return 1;
+    }
+
+    /* The palette is gone with the framebuffer */
+    TTFT_SetTransport( DeviceHandle, Case->Transport, TTFT_DefaultPollingThreshold );
+    SetPalette( DeviceHandle );
+
+    DrawScene( DeviceHandle, 100 );
+    TTFT_Update( DeviceHandle );
+
+    SnapshotFrameBuffer( Case, DeviceHandle, Expected, false );
+    Mismatches+= CheckGRAM( Case, "resumed", DeviceHandle, Panel, Expected );
+    Mismatches+= CheckPartial( Case, "resumed", DeviceHandle, Panel, Expected, 150 );
+
+    return Mismatches;
+}
+
+/*
+ * RunCase:
+ * Draws a scene, updates and checks, then does the same in partial mode
+ * and once more after leaving it.
+ * Resumed cases then repeat all of that after sleeping.
+ * Returns true if GRAM matched every time.
+ */
+static bool RunCase( const struct TestCase* Case ) {
+    static struct TTFT_Device Device;
+    struct TTFT_HostPanel Panel;
+    uint32_t* Expected = NULL;
+    int Mismatches = 0;
+    int Width = PanelWidth;
+    int Height = PanelHeight;
+
+    memset( &Device, 0, sizeof( Device ) );
+
+    /* Landscape framebuffer on a portrait panel */
+    if ( Case->IsExchanged == true ) {
+        Width = PanelHeight;
+        Height = PanelWidth;
+    }
+
+    if ( TTFT_HostPanelInit( &Panel, PanelWidth, PanelHeight ) == false ) {
+        printf( "%s: failed to set up the panel\n", Case->Name );
+        return false;
+    }
+
+    if ( TTFT_InitHost( &Device, Width, Height, &Panel, TTFT_Reset_ILI9341, Case->Flags ) == false || ( Expected = calloc( Width * Height, sizeof( uint32_t ) ) ) == NULL ) {
+        printf( "%s: failed to set up the device\n", Case->Name );
+        TTFT_HostPanelFree( &Panel );
+
+        return false;
+    }
+
+    if ( Case->IsExchanged == true ) {
+        TTFT_SendCommand( &Device, REG_MADCTL, MADCTL_MV );
+    }
+
+    TTFT_SetTransport( &Device, Case->Transport, TTFT_DefaultPollingThreshold );
+
+    SetPalette( &Device );
+
+    DrawScene( &Device, 0 );
+    TTFT_Update( &Device );
+
+    SnapshotFrameBuffer( Case, &Device, Expected, false );
+    Mismatches+= CheckGRAM( Case, "full", &Device, &Panel, Expected );
+
+    Mismatches+= CheckPartial( Case, "first", &Device, &Panel, Expected, 50 );
+
+    if ( Case->IsResumed == true ) {
+        Mismatches+= CheckResume( Case, &Device, &Panel, Expected );
+    }
+
+    printf( "%s: %s\n", Case->Name, ( Mismatches == 0 ) ? "ok" : "FAILED" );
+
+    free( Expected );
+    TTFT_DeInit( &Device );
+    TTFT_HostPanelFree( &Panel );
+
+    return Mismatches == 0;
+}
+
+int main( int Argc, char** Argv ) {
+    bool Passed = true;
+    size_t i = 0;
+
+    for ( i = 0; i < sizeof( TestCases ) / sizeof( TestCases[ 0 ] ); i++ ) {
+        if ( Argc > 1 && strcmp( Argv[ 1 ], TestCases[ i ].Name ) != 0 ) {
+            continue;
+        }
+
+        Passed&= RunCase( &TestCases[ i ] );
+    }
+
+    return ( Passed == true ) ? 0 : 1;
+}
@@ -12,14 +12,75 @@
 #include <math.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "driver/spi_master.h"
+#include "freertos/event_groups.h"
 #include "driver/gpio.h"
-#include "soc/spi_struct.h"
 #include "esp_log.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
 #include "ttft.h"
+#include "ttft_trace.h"
+#include "ttft_profile.h"
+
+/* Written by TTFT_Sleep, survives deep sleep but not power loss */
+#define ResumeMagic 0x54544654
+
+struct TTFT_ResumeMarker {
+    uint32_t Magic;
+    int Width;
+    int Height;
+    int DCPin;
+
+    /* What the controller was left in, the reset procedure that set these doesn't run on resume */
+    TTFT_PixelFormat PixelFormat;
+    uint8_t AddressMode;
+};
+
+static RTC_NOINIT_ATTR struct TTFT_ResumeMarker ResumeMarker;
+
+/* Writes kept in flight by TTFT_SendSolid, no more than TTFT_TransportQueueDepth */
+#define PanelQueueDepth 8
+
+static const uint8_t SleepTable[ ] = {
+    /* Display off */
+    0x28, 0,
+
+    /* Sleep in, 5ms before the next command */
+    0x10, TTFT_InitDelay | 0, 5,
+
+    TTFT_InitEnd
+};
+
+static const uint8_t WakeTable[ ] = {
+    /* Sleep out, 5ms before the next command */
+    0x11, TTFT_InitDelay | 0, 5,
+
+    /* Display on */
+    0x29, 0,
+
+    TTFT_InitEnd
+};
 
 static void IRAM_ATTR SwapInt( int* A, int* B );
-static void IRAM_ATTR TTFT_PreTransferCallback( spi_transaction_t* Transaction );
+static void TTFT_InitTask( void* Param );
+static bool TTFT_InitFailed( struct TTFT_Device* DeviceHandle, bool IsOpen );
+static bool TTFT_CanResume( struct TTFT_Device* DeviceHandle );
+static uint32_t TTFT_EncodeColor( TTFT_PixelFormat Format, Color_t Color );
+static void TTFT_BuildWirePalette( struct TTFT_Device* DeviceHandle );
+static void IRAM_ATTR TTFT_ConvertRow565( const uint32_t* Palette, const uint8_t* In, uint8_t* Out, int Count );
+static void IRAM_ATTR TTFT_ConvertRow666( const uint32_t* Palette, const uint8_t* In, uint8_t* Out, int Count );
+static bool IRAM_ATTR TTFT_SendSolid( struct TTFT_Device* DeviceHandle, uint8_t Color, int Count );
+static void IRAM_ATTR TTFT_LockBus( struct TTFT_Device* DeviceHandle );
+static void IRAM_ATTR TTFT_SPIWaitQueued( struct TTFT_Device* DeviceHandle, int MaxQueued );
+static inline bool TTFT_QueueTransfer( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t DataLength );
+static inline void TTFT_WaitTransfer( struct TTFT_Device* DeviceHandle );
+static inline void TTFT_TraceQueued( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t DataLength, bool IsCommand, int64_t Now );
+static inline void TTFT_TraceCompleted( struct TTFT_Device* DeviceHandle, int64_t Now );
+static void IRAM_ATTR TTFT_StatsAdd( struct TTFT_StatsValue* Value, int64_t Sample, uint32_t Count );
+static void IRAM_ATTR TTFT_RecordFlush( struct TTFT_Device* DeviceHandle, int Area, int64_t Elapsed );
+static void IRAM_ATTR TTFT_SPIWriteQueued( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t DataLength );
+static void IRAM_ATTR TTFT_YieldBus( struct TTFT_Device* DeviceHandle );
+static void IRAM_ATTR TTFT_FillSpan( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1, uint8_t Color );
 static void TTFT_SetAddressWindow( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1 );
 static void IRAM_ATTR TTFT_DrawWideLine( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1, uint8_t Color );
 static void IRAM_ATTR TTFT_DrawTallLine( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1, uint8_t Color );
@@ -36,420 +97,314 @@ static void IRAM_ATTR SwapInt( int* A, int* B ) {
 }
 
 /*
- * TTFT_PreTransferCallback:
- * This manages the state of the data/command pin before SPI transfers.
+ * TTFT_InitTask:
+ * Runs the reset procedure in the background for TTFT_InitFlag_Async.
  */
-static void IRAM_ATTR TTFT_PreTransferCallback( spi_transaction_t* Transaction ) {
-    int DCState = 0;
-    int DCPin = 0;
-    int User = 0;
-    
-    if ( Transaction != NULL ) {
-        User = ( int ) Transaction->user;
-        DCState = ( User >> 8 ) & 0xFF;
-        DCPin = User & 0xFF;
+static void TTFT_InitTask( void* Param ) {
+    struct TTFT_Device* DeviceHandle = ( struct TTFT_Device* ) Param;
 
-        gpio_set_level( DCPin, DCState );
-    }
+    DeviceHandle->ResetProc( DeviceHandle );
+    TTFT_SetBacklight( DeviceHandle, true );
+
+    DeviceHandle->IsReady = true;
+    xEventGroupSetBits( DeviceHandle->InitEvents, TTFT_Event_Ready );
+
+    vTaskDelete( NULL );
 }
 
 /*
- * SPIMasterInit:
- * Initializes the SPI bus with the given pins.
+ * TTFT_CanResume:
+ * Returns true if we woke from deep sleep and TTFT_Sleep left a display with the same setup.
  */
-bool SPIMasterInit( int MOSIPin, int MISOPin, int SCLKPin ) {
-    const spi_bus_config_t SPIBusConfig = {
-        .mosi_io_num = MOSIPin,
-        .miso_io_num = MISOPin,
-        .sclk_io_num = SCLKPin,
-        .quadwp_io_num = -1,
-        .quadhd_io_num = -1,
-        .flags = SPICOMMON_BUSFLAG_NATIVE_PINS,
-        .max_transfer_sz = 16384 * 8
-    };
+static bool TTFT_CanResume( struct TTFT_Device* DeviceHandle ) {
+    if ( esp_sleep_get_wakeup_cause( ) == ESP_SLEEP_WAKEUP_UNDEFINED ) {
+        return false;
+    }
 
-    ESP_ERROR_CHECK_NONFATAL( spi_bus_initialize( VSPI_HOST, &SPIBusConfig, 1 ), return false );
-    return true;
+    return ResumeMarker.Magic == ResumeMagic &&
+        ResumeMarker.Width == DeviceHandle->Width &&
+        ResumeMarker.Height == DeviceHandle->Height &&
+        ResumeMarker.DCPin == DeviceHandle->DCPin &&
+        ( ResumeMarker.PixelFormat == TTFT_PixelFormat_RGB565 || ResumeMarker.PixelFormat == TTFT_PixelFormat_RGB666 );
 }
 
 /*
- * Initializes and resets the LCD device connected to the given GPIO pins.
- * 
- * Required parameters:
- * Width:   Width of the Display
- * Height:  Height of the display
- * DCPin:   Data/command selection pin
+ * TTFT_InitTransport:
+ * Same as TTFT_InitEx for a display reached through (Ops), which gets (Param) when opened.
  * 
- * Optional parameters:
- * CSPin:           Can be held low if nothing else will be on the SPI bus
- * ResetPin:        Can be held high to skip hardware reset, TTFT_Reset will still reset the device in software.
- * BacklightPin:    Can be held high to be always on or if you're going to manage it yourself.
- * ResetProc:       Pointer to device specific reset function which should send commands needed to initialize the display.
- * SPIFrequency:    Frequency in Hz to drive the SPI display at.
- */
-bool TTFT_Init( struct TTFT_Device* DeviceHandle, int Width, int Height, int CSPin, int DCPin, int ResetPin, int BacklightPin, void ( *ResetProc ) ( struct TTFT_Device* ), int SPIFrequency ) {
+ * With TTFT_InitFlag_Async the display is reset in a background task while the caller carries on,
+ * drawing into the framebuffer is fine right away and updates wait for the display to be ready.
+ */
+bool TTFT_InitTransport( struct TTFT_Device* DeviceHandle, int Width, int Height, int BacklightPin, const struct TTFT_TransportOps* Ops, void* Param, void ( *ResetProc ) ( struct TTFT_Device* ), int Flags ) {
     int Size = ( Width * Height );
 
-    const spi_device_interface_config_t SPIDeviceConfig = {
-        .clock_speed_hz = SPIFrequency,
-        .spics_io_num = CSPin,
-        .queue_size = 8,
-        .flags = SPI_DEVICE_HALFDUPLEX,
-        .pre_cb = TTFT_PreTransferCallback
-    };
     gpio_config_t IOOutputs = {
         .pin_bit_mask = 0,
         .mode = GPIO_MODE_OUTPUT
     };
 
     NullCheck( DeviceHandle, return false );
+    NullCheck( Ops, return false );
     NullCheck( ResetProc, return false );
 
-    if ( DCPin == -1 ) {
-        ESP_LOGE( __FUNCTION__, "Need a D/C pin to function properly!" );
-        return false;
-    }
+    DeviceHandle->IsImmediate = ( Flags & TTFT_InitFlag_NoFrameBuffer ) ? true : false;
+    DeviceHandle->FrameBuffer = NULL;
+    DeviceHandle->FillBuffer = NULL;
 
-    NullCheck( ( DeviceHandle->FrameBuffer = malloc( Size ) ), return false );
+    /* Big enough for 18 bit colour, updates send solid runs from it so it can't be left until later */
+    NullCheck( ( DeviceHandle->FillBuffer = heap_caps_malloc( TTFT_FillBufferPixels * 3, MALLOC_CAP_DMA ) ), return false );
+
+    if ( DeviceHandle->IsImmediate == false ) {
+        NullCheck( ( DeviceHandle->FrameBuffer = malloc( Size ) ), return TTFT_InitFailed( DeviceHandle, false ) );
+    }
     memset( DeviceHandle->Palette, 0, sizeof( DeviceHandle->Palette ) );
 
+    DeviceHandle->PixelFormat = ( Flags & TTFT_InitFlag_RGB666 ) ? TTFT_PixelFormat_RGB666 : TTFT_PixelFormat_RGB565;
+    TTFT_BuildWirePalette( DeviceHandle );
+
+    DeviceHandle->Transport = TTFT_Transport_Auto;
+    DeviceHandle->PollingThreshold = TTFT_DefaultPollingThreshold;
+    DeviceHandle->QueuedCount = 0;
+
+    DeviceHandle->ShareBus = ( Flags & TTFT_InitFlag_ShareBus ) ? true : false;
+    DeviceHandle->BusLockDepth = 0;
+    DeviceHandle->BusLockCount = 0;
+    DeviceHandle->BusLockTime = 0;
+
+    memset( &DeviceHandle->Stats, 0, sizeof( DeviceHandle->Stats ) );
+
+    DeviceHandle->Trace = NULL;
+    DeviceHandle->TraceSize = 0;
+    DeviceHandle->TraceHead = 0;
+    DeviceHandle->TraceDone = 0;
+
+    /* Pins belong to the transport, it fills in the ones it uses when opened */
     DeviceHandle->BacklightPin = BacklightPin;
-    DeviceHandle->ResetPin = ResetPin;
-    DeviceHandle->CSPin = CSPin;
-    DeviceHandle->DCPin = DCPin;
+    DeviceHandle->ResetPin = -1;
+    DeviceHandle->CSPin = -1;
+    DeviceHandle->DCPin = -1;
     DeviceHandle->Width = Width;
     DeviceHandle->Height = Height;
-    DeviceHandle->Handle = NULL;
+    DeviceHandle->Ops = Ops;
+    DeviceHandle->TransportState = NULL;
+    DeviceHandle->ResetProc = ResetProc;
+    DeviceHandle->InitEvents = NULL;
+    DeviceHandle->IsReady = false;
+    DeviceHandle->IsResumed = false;
     DeviceHandle->Font = NULL;
     DeviceHandle->FontGetGlyphWidth = NULL;
+    DeviceHandle->FontScale = 1;
+    DeviceHandle->FontStyle = 0;
+    DeviceHandle->AddressMode = 0;
+    DeviceHandle->PartialX0 = 0;
+    DeviceHandle->PartialY0 = 0;
+    DeviceHandle->PartialX1 = Width - 1;
+    DeviceHandle->PartialY1 = Height - 1;
+    DeviceHandle->IsPartial = false;
+    DeviceHandle->IsIdle = false;
+
+    TTFT_ClearDirty( DeviceHandle );
 
-    IOOutputs.pin_bit_mask |= ( DCPin > -1 ) ? ( 1ULL << DCPin ) : 0;
-    IOOutputs.pin_bit_mask |= ( ResetPin > -1 ) ? ( 1ULL << ResetPin ) : 0;
-    IOOutputs.pin_bit_mask |= ( BacklightPin > -1 ) ? ( 1ULL << BacklightPin ) : 0;
+    if ( BacklightPin > -1 ) {
+        IOOutputs.pin_bit_mask = ( 1ULL << BacklightPin );
 
-    /* Set default values for gpio outputs */
-    if ( ResetPin > -1 ) {
-        gpio_set_level( ResetPin, 0 );
+        gpio_set_level( BacklightPin, 0 );
+        ESP_ERROR_CHECK_NONFATAL( gpio_config( &IOOutputs ), return TTFT_InitFailed( DeviceHandle, false ) );
     }
 
-    if ( BacklightPin > -1 ) {
-        gpio_set_level( BacklightPin, 0 );
+    if ( Ops->Open( DeviceHandle, Param ) == false ) {
+        ESP_LOGE( __FUNCTION__, "Failed to open display transport" );
+        return TTFT_InitFailed( DeviceHandle, false );
+    }
+
+    if ( Flags & TTFT_InitFlag_Resume ) {
+        DeviceHandle->IsResumed = TTFT_CanResume( DeviceHandle );
     }
 
-    if ( DCPin > -1 ) {
-        gpio_set_level( DCPin, 0 );
+    /* Only good for one wake, anything after this needs another TTFT_Sleep */
+    ResumeMarker.Magic = 0;
+
+    if ( DeviceHandle->IsResumed == true ) {
+        /* The controller kept its pixel format through sleep, that wins over TTFT_InitFlag_RGB666 */
+        DeviceHandle->PixelFormat = ResumeMarker.PixelFormat;
+        DeviceHandle->AddressMode = ResumeMarker.AddressMode;
+        TTFT_BuildWirePalette( DeviceHandle );
+
+        DeviceHandle->ResetProc = TTFT_Wake;
+    }
+    else {
+        /* Hold the display in reset until the reset procedure runs, a resumed display must not see this */
+        Ops->SetReset( DeviceHandle, false );
     }
 
-    ESP_ERROR_CHECK_NONFATAL( gpio_config( &IOOutputs ), return false );
-    ESP_ERROR_CHECK_NONFATAL( spi_bus_add_device( VSPI_HOST, &SPIDeviceConfig, &DeviceHandle->Handle ), return false );
+    NullCheck( ( DeviceHandle->InitEvents = xEventGroupCreate( ) ), return TTFT_InitFailed( DeviceHandle, true ) );
+
+    if ( Flags & TTFT_InitFlag_Async ) {
+        if ( xTaskCreate( TTFT_InitTask, "TTFT_Init", 3072, DeviceHandle, uxTaskPriorityGet( NULL ), NULL ) != pdPASS ) {
+            ESP_LOGE( __FUNCTION__, "Failed to create init task" );
+            return TTFT_InitFailed( DeviceHandle, true );
+        }
+
+        return true;
+    }
 
-    ResetProc( DeviceHandle );
+    DeviceHandle->ResetProc( DeviceHandle );
 
     /* Turn on backlight if we control the pin */
     TTFT_SetBacklight( DeviceHandle, true );
+
+    DeviceHandle->IsReady = true;
+    xEventGroupSetBits( DeviceHandle->InitEvents, TTFT_Event_Ready );
     return true;
 }
 
 /*
- * TTFT_DeInit:
- * Frees memory used by the shadow framebuffer and zeroes out the device handle.
+ * TTFT_InitFailed:
+ * Undoes whatever TTFT_InitTransport got to before failing, (IsOpen) if that includes opening the transport.
+ * Always returns false.
  */
-void TTFT_DeInit( struct TTFT_Device* DeviceHandle ) {
-    NullCheck( DeviceHandle, return );
+static bool TTFT_InitFailed( struct TTFT_Device* DeviceHandle, bool IsOpen ) {
+    if ( DeviceHandle->InitEvents != NULL ) {
+        vEventGroupDelete( DeviceHandle->InitEvents );
+        DeviceHandle->InitEvents = NULL;
+    }
+
+    if ( IsOpen == true ) {
+        DeviceHandle->Ops->Close( DeviceHandle );
+    }
 
     if ( DeviceHandle->FrameBuffer != NULL ) {
         heap_caps_free( DeviceHandle->FrameBuffer );
+        DeviceHandle->FrameBuffer = NULL;
     }
 
-    memset( DeviceHandle, 0, sizeof( struct TTFT_Device ) );
+    if ( DeviceHandle->FillBuffer != NULL ) {
+        heap_caps_free( DeviceHandle->FillBuffer );
+        DeviceHandle->FillBuffer = NULL;
+    }
+
+    return false;
 }
 
 /*
- * TTFT_SetBacklight:
- * Turns the backlight on or off if a backlight control pin was given on init.
- * If not, this will have no effect.
+ * TTFT_IsReady:
+ * Returns true once the display has finished resetting.
  */
-void TTFT_SetBacklight( struct TTFT_Device* DeviceHandle, bool On ) {
-    NullCheck( DeviceHandle, return );
-
-    if ( DeviceHandle->BacklightPin > -1 ) {
-        ESP_ERROR_CHECK_NONFATAL( gpio_set_level( DeviceHandle->BacklightPin, ( On == true ) ? 1 : 0 ), return );
-    }
+bool TTFT_IsReady( struct TTFT_Device* DeviceHandle ) {
+    NullCheck( DeviceHandle, return false );
+    return DeviceHandle->IsReady;
 }
 
 /*
- * TTFT_Reset_ST7735:
- * Reset and init sequence for the ST7735 display controller.
+ * TTFT_WaitReady:
+ * Waits up to (Timeout) ticks for the display to finish resetting.
+ * Returns true if the display is ready.
  */
-void TTFT_Reset_ST7735( struct TTFT_Device* DeviceHandle ) {
-    NullCheck( DeviceHandle, return );
-
-    if ( DeviceHandle->ResetPin > -1 ) {
-        ESP_ERROR_CHECK_NONFATAL( gpio_set_level( DeviceHandle->ResetPin, 1 ), return );
-        vTaskDelay( pdMS_TO_TICKS( 150 ) );
-
-        ESP_ERROR_CHECK_NONFATAL( gpio_set_level( DeviceHandle->ResetPin, 0 ), return );
-        vTaskDelay( pdMS_TO_TICKS( 150 ) );
+bool TTFT_WaitReady( struct TTFT_Device* DeviceHandle, TickType_t Timeout ) {
+    NullCheck( DeviceHandle, return false );
 
-        ESP_ERROR_CHECK_NONFATAL( gpio_set_level( DeviceHandle->ResetPin, 1 ), return );
-        vTaskDelay( pdMS_TO_TICKS( 150 ) );
+    if ( DeviceHandle->IsReady == false ) {
+        NullCheck( DeviceHandle->InitEvents, return false );
+        xEventGroupWaitBits( DeviceHandle->InitEvents, TTFT_Event_Ready, pdFALSE, pdTRUE, Timeout );
     }
 
-    /* Software reset */
-    TTFT_SendCommand(
-        DeviceHandle,
-        0x01
-    );
-
-    vTaskDelay( pdMS_TO_TICKS( 100 ) );
-
-    /* Sleep out */
-    TTFT_SendCommand(
-        DeviceHandle,
-        0x11
-    );
-
-    vTaskDelay( pdMS_TO_TICKS( 100 ) );
-
-    /* Gamma curve select */
-    TTFT_SendCommand(
-        DeviceHandle,
-        0x26,
-        0x04
-    );
-
-    /* Depth */
-    TTFT_SendCommand(
-        DeviceHandle,
-        0x3A,
-        PixelFormat
-    );
-
-    /* madctl */
-    TTFT_SendCommand(
-        DeviceHandle,
-        0x36,
-        0x00
-    );
-
-    /* Partial mode off */
-    TTFT_SendCommand(
-        DeviceHandle,
-        0x13
-    );
-    
-    /* Frame rate control */
-    TTFT_SendCommand(
-        DeviceHandle,
-        0xB1,
-        0x06,
-        0x01,
-        0x01
-    );
-
-    /* Display on */
-    TTFT_SendCommand(
-        DeviceHandle,
-        0x29
-    );
+    return DeviceHandle->IsReady;
 }
 
 /*
- * TTFT_Reset_ILI9341:
- * Reset and init sequency for the ST7735 display controller.
+ * TTFT_Sleep:
+ * Turns the display off and puts the controller to sleep, GRAM and all settings are kept.
+ * Call before entering deep sleep so TTFT_InitFlag_Resume can skip the full init on wake.
+ * 
+ * Note:
+ * The reset pin is held high through deep sleep and the display must stay powered.
  */
-void TTFT_Reset_ILI9341( struct TTFT_Device* DeviceHandle ) {
+void TTFT_Sleep( struct TTFT_Device* DeviceHandle ) {
     NullCheck( DeviceHandle, return );
 
-    if ( DeviceHandle->ResetPin > -1 ) {
-        ESP_ERROR_CHECK_NONFATAL( gpio_set_level( DeviceHandle->ResetPin, 1 ), return );
-        vTaskDelay( pdMS_TO_TICKS( 150 ) );
-
-        ESP_ERROR_CHECK_NONFATAL( gpio_set_level( DeviceHandle->ResetPin, 0 ), return );
-        vTaskDelay( pdMS_TO_TICKS( 150 ) );
-
-        ESP_ERROR_CHECK_NONFATAL( gpio_set_level( DeviceHandle->ResetPin, 1 ), return );
-        vTaskDelay( pdMS_TO_TICKS( 150 ) );
+    if ( TTFT_WaitReady( DeviceHandle, portMAX_DELAY ) == false ) {
+        return;
     }
 
-    /* 
-     * TTFT Init sequence from fbcp-TTFT:
-     * https://github.com/juj/fbcp-TTFT
-     */
-
-    /* Software reset plus 120ms delay */
-    TTFT_SendCommand( 
-        DeviceHandle, 
-        0x01 
-    );
-
-    vTaskDelay( pdMS_TO_TICKS( 120 ) );
-
-    /* Display off */
-    TTFT_SendCommand( 
-        DeviceHandle,
-        0x28
-    );
-
-    /* Power control A */
-    TTFT_SendCommand(
-        DeviceHandle,
-        0xCB,
-        0x39,
-        0x2C,
-        0x00,
-        0x34,
-        0x02
-    );
-
-    /* Power control B */
-    TTFT_SendCommand(
-        DeviceHandle,
-        0xCF,
-        0x00,
-        0xC1,
-        0x30
-    );
-
-    /* Driver timing control A */
-    TTFT_SendCommand(
-        DeviceHandle,
-        0xE8,
-        0x85,
-        0x00,
-        0x78
-    );
-
-    /* Driver timing control B */
-    TTFT_SendCommand(
-        DeviceHandle,
-        0xEA,
-        0x00,
-        0x00
-    );
-
-    /* Power on sequence control */
-    TTFT_SendCommand(
-        DeviceHandle,
-        0xED,
-        0x64,
-        0x03,
-        0x12,
-        0x81
-    );
-
-    /* Power control 1 */
-    TTFT_SendCommand( 
-        DeviceHandle,
-        0xC0,
-        0x23
-    );
-
-    /* Power control 2 */
-    TTFT_SendCommand( 
-        DeviceHandle,
-        0xC1,
-        0x10
-    );
+    TTFT_SetBacklight( DeviceHandle, false );
+    TTFT_RunInitTable( DeviceHandle, SleepTable );
 
-    /* VCOM control 1 */
-    TTFT_SendCommand( 
-        DeviceHandle,
-        0xC5,
-        0x3E,
-        0x28
-    );
+    if ( DeviceHandle->ResetPin > -1 ) {
+        ESP_ERROR_CHECK_NONFATAL( gpio_hold_en( DeviceHandle->ResetPin ), return );
+        gpio_deep_sleep_hold_en( );
+    }
 
-    /* VCOM control 2 */
-    TTFT_SendCommand( 
-        DeviceHandle,
-        0xC7,
-        0x86
-    );
+    ResumeMarker.Width = DeviceHandle->Width;
+    ResumeMarker.Height = DeviceHandle->Height;
+    ResumeMarker.DCPin = DeviceHandle->DCPin;
+    ResumeMarker.PixelFormat = DeviceHandle->PixelFormat;
+    ResumeMarker.AddressMode = DeviceHandle->AddressMode;
+    ResumeMarker.Magic = ResumeMagic;
+}
 
-    /* madctl */
-    TTFT_SendCommand( 
-        DeviceHandle,
-        0x36,
-        0x00
-    );
+/*
+ * TTFT_Wake:
+ * Takes the controller out of sleep and turns the display back on.
+ * The display shows whatever was in GRAM before TTFT_Sleep.
+ */
+void TTFT_Wake( struct TTFT_Device* DeviceHandle ) {
+    NullCheck( DeviceHandle, return );
 
-    /* Display inversion off */
-    TTFT_SendCommand( 
-        DeviceHandle,
-        0x20
-    );
+    ResumeMarker.Magic = 0;
 
-    /* Pixel format */
-    TTFT_SendCommand( 
-        DeviceHandle,
-        0x3A,
-        PixelFormat
-    );
+    TTFT_RunInitTable( DeviceHandle, WakeTable );
+    TTFT_SetBacklight( DeviceHandle, true );
+}
 
-    /* Frame rate control */
-    TTFT_SendCommand( 
-        DeviceHandle,
-        0xB1,
-        0x00,
-        0x1B
-    );
+/*
+ * TTFT_IsResumed:
+ * Returns true if TTFT_InitEx resumed a sleeping display rather than resetting it.
+ * The framebuffer does not survive deep sleep but the display still shows the last frame.
+ */
+bool TTFT_IsResumed( struct TTFT_Device* DeviceHandle ) {
+    NullCheck( DeviceHandle, return false );
+    return DeviceHandle->IsResumed;
+}
 
-    /* Display function control */
-    TTFT_SendCommand( 
-        DeviceHandle,
-        0xB6,
-        0x08,
-        0x82,
-        0x27
-    );
+/*
+ * TTFT_DeInit:
+ * Frees memory used by the shadow framebuffer and zeroes out the device handle.
+ */
+void TTFT_DeInit( struct TTFT_Device* DeviceHandle ) {
+    NullCheck( DeviceHandle, return );
 
-    /* Enable 3G */
-    TTFT_SendCommand( 
-        DeviceHandle,
-        0xF2,
-        0x02
-    );
+    if ( DeviceHandle->InitEvents != NULL ) {
+        /* Don't pull the device out from under the init task */
+        TTFT_WaitReady( DeviceHandle, portMAX_DELAY );
+        vEventGroupDelete( DeviceHandle->InitEvents );
+    }
 
-    /* Gamma set */
-    TTFT_SendCommand( 
-        DeviceHandle,
-        0x26,
-        0x01
-    );
+    if ( DeviceHandle->Ops != NULL ) {
+        DeviceHandle->Ops->Close( DeviceHandle );
+    }
 
-    /* Positive gamma correction */
-    TTFT_SendCommand( 
-        DeviceHandle,
-        0xE0, 0x0F, 0x31, 0x2B,
-        0x0C, 0x0E, 0x08, 0x4E,
-        0xF1, 0x37, 0x07, 0x10,
-        0x03, 0x0E, 0x09, 0x00
-    );
+    if ( DeviceHandle->FrameBuffer != NULL ) {
+        heap_caps_free( DeviceHandle->FrameBuffer );
+    }
 
-    /* Negative gamma correction */
-    TTFT_SendCommand( 
-        DeviceHandle,
-        0xE1, 0x00, 0x0E, 0x14,
-        0x03, 0x11, 0x07, 0x31,
-        0xC1, 0x48, 0x08, 0x0F,
-        0x0C, 0x31, 0x36, 0x0F
-    );
+    if ( DeviceHandle->FillBuffer != NULL ) {
+        heap_caps_free( DeviceHandle->FillBuffer );
+    }
 
-    /* Sleep out */
-    TTFT_SendCommand( 
-        DeviceHandle,
-        0x11
-    );
+    memset( DeviceHandle, 0, sizeof( struct TTFT_Device ) );
+}
 
-    /* 120ms delay */
-    vTaskDelay( pdMS_TO_TICKS( 120 ) );
+/*
+ * TTFT_SetBacklight:
+ * Turns the backlight on or off if a backlight control pin was given on init.
+ * If not, this will have no effect.
+ */
+void TTFT_SetBacklight( struct TTFT_Device* DeviceHandle, bool On ) {
+    NullCheck( DeviceHandle, return );
 
-    /* Display on */
-    TTFT_SendCommand( 
-        DeviceHandle,
-        0x29
-    );
+    if ( DeviceHandle->BacklightPin > -1 ) {
+        ESP_ERROR_CHECK_NONFATAL( gpio_set_level( DeviceHandle->BacklightPin, ( On == true ) ? 1 : 0 ), return );
+    }
 }
 
 /*
@@ -493,51 +448,431 @@ static void IRAM_ATTR TTFT_SetAddressWindow( struct TTFT_Device* DeviceHandle, i
 }
 
 /*
- * TTFT_SetPalette:
- * Sets the given alette as the new palette used to convert from indexed colour during updates.
+ * TTFT_LockBus:
+ * Acquires the bus and keeps track of how long that took.
+ * Does nothing for transports that don't share a bus.
  */
-void TTFT_SetPalette( struct TTFT_Device* DeviceHandle, const Color_t* NewPalette, size_t NewPaletteSize ) {
-    NullCheck( DeviceHandle, return );
-    NullCheck( NewPalette, return );
+static void IRAM_ATTR TTFT_LockBus( struct TTFT_Device* DeviceHandle ) {
+    int64_t Start = esp_timer_get_time( );
 
-    memcpy( DeviceHandle->Palette, NewPalette, NewPaletteSize );
+    if ( DeviceHandle->Ops->Lock == NULL || DeviceHandle->Ops->Lock( DeviceHandle ) == false ) {
+        return;
+    }
+
+    Start = esp_timer_get_time( ) - Start;
+
+    DeviceHandle->BusLockTime+= Start;
+    DeviceHandle->FlushWaitTime+= Start;
+    DeviceHandle->BusLockCount++;
 }
 
 /*
- * TTFT_SetPaletteEntry:
- * Sets a single entry in the palette to the given RGB values.
+ * TTFT_YieldBus:
+ * If the bus is being shared, gives anything waiting for it a turn between chunks.
+ * All transactions must have completed.
  */
-void TTFT_SetPaletteEntry( struct TTFT_Device* DeviceHandle, uint8_t Index, uint8_t Red, uint8_t Green, uint8_t Blue ) {
-    Color_t Color = RGB( Red, Green, Blue );
+static void IRAM_ATTR TTFT_YieldBus( struct TTFT_Device* DeviceHandle ) {
+    if ( DeviceHandle->ShareBus == true && DeviceHandle->BusLockDepth > 0 ) {
+        TTFT_SPIWaitQueued( DeviceHandle, 0 );
 
-    NullCheck( DeviceHandle, return );
+        if ( DeviceHandle->Ops->Unlock != NULL ) {
+            DeviceHandle->Ops->Unlock( DeviceHandle );
+        }
 
-    DeviceHandle->Palette[ Index ] = Color;
+        taskYIELD( );
+
+        TTFT_LockBus( DeviceHandle );
+    }
 }
 
 /*
- * TTFT_Clear:
- * Clears the entire screen with the given colour index.
+ * TTFT_AcquireBus:
+ * Takes the SPI bus for this display until the matching TTFT_ReleaseBus so each transaction
+ * doesn't have to, calls can be nested. Updates and direct panel writes do this themselves,
+ * wrapping a whole frame of immediate mode drawing saves taking it for every primitive.
  */
-void TTFT_Clear( struct TTFT_Device* DeviceHandle, uint8_t Color ) {
+void TTFT_AcquireBus( struct TTFT_Device* DeviceHandle ) {
     NullCheck( DeviceHandle, return );
-    NullCheck( DeviceHandle->FrameBuffer, return );
 
-    memset( DeviceHandle->FrameBuffer, Color, DeviceHandle->Width * DeviceHandle->Height );
+    if ( DeviceHandle->BusLockDepth++ == 0 ) {
+        DeviceHandle->BusLockCount = 0;
+        DeviceHandle->BusLockTime = 0;
+
+        TTFT_LockBus( DeviceHandle );
+    }
 }
 
 /*
- * TTFT_PutPixel:
- * Draws a single pixel at the given x,y coordinates.
+ * TTFT_ReleaseBus:
+ * Releases the SPI bus once every TTFT_AcquireBus has been matched.
+ */
+void TTFT_ReleaseBus( struct TTFT_Device* DeviceHandle ) {
+    NullCheck( DeviceHandle, return );
+
+    if ( DeviceHandle->BusLockDepth > 0 && --DeviceHandle->BusLockDepth == 0 && DeviceHandle->Ops->Unlock != NULL ) {
+        DeviceHandle->Ops->Unlock( DeviceHandle );
+    }
+}
+
+/*
+ * TTFT_SetBusSharing:
+ * When on the bus is released and taken again between chunks of an update so other devices
+ * on the bus don't have to wait for the whole frame. Off by default.
+ */
+void TTFT_SetBusSharing( struct TTFT_Device* DeviceHandle, bool On ) {
+    NullCheck( DeviceHandle, return );
+
+    DeviceHandle->ShareBus = On;
+}
+
+/*
+ * TTFT_GetBusLockStats:
+ * Returns how many times the bus was acquired and how long that took in microseconds,
+ * counted from the last time TTFT_AcquireBus took the lock (ie. the last update).
+ * Either pointer can be NULL.
+ */
+void TTFT_GetBusLockStats( struct TTFT_Device* DeviceHandle, int* OutCount, int64_t* OutMicroseconds ) {
+    NullCheck( DeviceHandle, return );
+
+    if ( OutCount != NULL ) {
+        *OutCount = DeviceHandle->BusLockCount;
+    }
+
+    if ( OutMicroseconds != NULL ) {
+        *OutMicroseconds = DeviceHandle->BusLockTime;
+    }
+}
+
+/*
+ * TTFT_GetStats:
+ * Copies the flush statistics of (DeviceHandle) into (OutStats).
+ */
+void TTFT_GetStats( struct TTFT_Device* DeviceHandle, struct TTFT_FlushStats* OutStats ) {
+    NullCheck( DeviceHandle, return );
+    NullCheck( OutStats, return );
+
+    memcpy( OutStats, &DeviceHandle->Stats, sizeof( struct TTFT_FlushStats ) );
+}
+
+/*
+ * TTFT_ResetStats:
+ * Starts the flush statistics over from nothing.
+ */
+void TTFT_ResetStats( struct TTFT_Device* DeviceHandle ) {
+    NullCheck( DeviceHandle, return );
+
+    memset( &DeviceHandle->Stats, 0, sizeof( struct TTFT_FlushStats ) );
+}
+
+/*
+ * TTFT_StatsAdd:
+ * Adds (Sample) to (Value), which is now holding (Count) samples.
+ */
+static void IRAM_ATTR TTFT_StatsAdd( struct TTFT_StatsValue* Value, int64_t Sample, uint32_t Count ) {
+    int Bucket = 0;
+
+    Value->Min = ( Count == 1 || Sample < Value->Min ) ? Sample : Value->Min;
+    Value->Max = ( Count == 1 || Sample > Value->Max ) ? Sample : Value->Max;
+    Value->Total+= Sample;
+
+    /* Position of the highest set bit, counting from 1 */
+    Bucket = ( Sample > 0 ) ? 64 - __builtin_clzll( ( uint64_t ) Sample ) : 0;
+    Bucket = ( Bucket >= TTFT_StatsBuckets ) ? TTFT_StatsBuckets - 1 : Bucket;
+
+    Value->Histogram[ Bucket ]++;
+}
+
+/*
+ * TTFT_RecordFlush:
+ * Adds the flush that just finished, which sent (Area) pixels and took (Elapsed) microseconds.
+ */
+static void IRAM_ATTR TTFT_RecordFlush( struct TTFT_Device* DeviceHandle, int Area, int64_t Elapsed ) {
+    struct TTFT_FlushStats* Stats = &DeviceHandle->Stats;
+    uint32_t Count = ++Stats->Flushes;
+
+    TTFT_StatsAdd( &Stats->Bytes, DeviceHandle->FlushBytes, Count );
+    TTFT_StatsAdd( &Stats->Transactions, DeviceHandle->FlushTransactions, Count );
+    TTFT_StatsAdd( &Stats->ConvertTime, Elapsed - DeviceHandle->FlushWaitTime, Count );
+    TTFT_StatsAdd( &Stats->WaitTime, DeviceHandle->FlushWaitTime, Count );
+    TTFT_StatsAdd( &Stats->Area, Area, Count );
+}
+
+/*
+ * TTFT_SetTransport:
+ * Picks how data is sent, transfers up to (PollingThreshold) bytes are polled in TTFT_Transport_Auto.
+ * Defaults to TTFT_Transport_Auto and TTFT_DefaultPollingThreshold.
+ */
+void TTFT_SetTransport( struct TTFT_Device* DeviceHandle, TTFT_Transport Transport, size_t PollingThreshold ) {
+    NullCheck( DeviceHandle, return );
+
+    TTFT_SPIWaitQueued( DeviceHandle, 0 );
+
+    DeviceHandle->Transport = Transport;
+    DeviceHandle->PollingThreshold = PollingThreshold;
+}
+
+/*
+ * TTFT_SetPartialArea:
+ * Only drives rows (y0) to (y1) of the display, the rest show the controller's non display colour.
+ * Updates are clipped to those rows so nothing outside is sent over SPI.
+ * 
+ * Note:
+ * Rows are in the display's native orientation, MADCTL rotation does not move them.
+ * They are converted to the framebuffer using the address mode at the time of the call,
+ * with MADCTL_MV set they are framebuffer columns. Send MADCTL first.
+ */
+void TTFT_SetPartialArea( struct TTFT_Device* DeviceHandle, int y0, int y1 ) {
+    bool IsExchanged = false;
+    bool IsMirrored = false;
+    int Rows = 0;
+
+    NullCheck( DeviceHandle, return );
+
+    /* With rows and columns exchanged the display's rows run across the framebuffer */
+    IsExchanged = ( DeviceHandle->AddressMode & MADCTL_MV ) ? true : false;
+    IsMirrored = ( DeviceHandle->AddressMode & ( IsExchanged ? MADCTL_MX : MADCTL_MY ) ) ? true : false;
+    Rows = IsExchanged ? DeviceHandle->Width : DeviceHandle->Height;
+
+    CheckBounds( y0, 0, y1, return );
+    CheckBounds( y1, y0, Rows - 1, return );
+
+    if ( TTFT_WaitReady( DeviceHandle, portMAX_DELAY ) == false ) {
+        return;
+    }
+
+    /* Partial area */
+    TTFT_SendCommand(
+        DeviceHandle,
+        0x30,
+        ( ( y0 >> 8 ) & 0xFF ),
+        ( y0 & 0xFF ),
+        ( ( y1 >> 8 ) & 0xFF ),
+        ( y1 & 0xFF )
+    );
+
+    /* Partial mode on */
+    TTFT_SendCommand(
+        DeviceHandle,
+        0x12
+    );
+
+    DeviceHandle->PartialX0 = 0;
+    DeviceHandle->PartialY0 = 0;
+    DeviceHandle->PartialX1 = DeviceHandle->Width - 1;
+    DeviceHandle->PartialY1 = DeviceHandle->Height - 1;
+
+    if ( IsExchanged == true ) {
+        DeviceHandle->PartialX0 = IsMirrored ? ( Rows - 1 ) - y1 : y0;
+        DeviceHandle->PartialX1 = IsMirrored ? ( Rows - 1 ) - y0 : y1;
+    }
+    else {
+        DeviceHandle->PartialY0 = IsMirrored ? ( Rows - 1 ) - y1 : y0;
+        DeviceHandle->PartialY1 = IsMirrored ? ( Rows - 1 ) - y0 : y1;
+    }
+
+    DeviceHandle->IsPartial = true;
+}
+
+/*
+ * TTFT_ClearPartialArea:
+ * Goes back to driving the whole display.
+ * Everything is marked dirty since rows outside the partial area were not being sent.
+ */
+void TTFT_ClearPartialArea( struct TTFT_Device* DeviceHandle ) {
+    NullCheck( DeviceHandle, return );
+
+    if ( DeviceHandle->IsPartial == false ) {
+        return;
+    }
+
+    if ( TTFT_WaitReady( DeviceHandle, portMAX_DELAY ) == false ) {
+        return;
+    }
+
+    /* Normal display mode on */
+    TTFT_SendCommand(
+        DeviceHandle,
+        0x13
+    );
+
+    DeviceHandle->PartialX0 = 0;
+    DeviceHandle->PartialY0 = 0;
+    DeviceHandle->PartialX1 = DeviceHandle->Width - 1;
+    DeviceHandle->PartialY1 = DeviceHandle->Height - 1;
+    DeviceHandle->IsPartial = false;
+
+    TTFT_MarkDirty( DeviceHandle, 0, 0, DeviceHandle->Width - 1, DeviceHandle->Height - 1 );
+}
+
+/*
+ * TTFT_SetIdleMode:
+ * In idle mode the display only shows 8 colours (the top bit of each channel) at a reduced frame rate.
+ * Saves power on screens that rarely change.
+ */
+void TTFT_SetIdleMode( struct TTFT_Device* DeviceHandle, bool On ) {
+    NullCheck( DeviceHandle, return );
+
+    if ( DeviceHandle->IsIdle == On ) {
+        return;
+    }
+
+    if ( TTFT_WaitReady( DeviceHandle, portMAX_DELAY ) == false ) {
+        return;
+    }
+
+    /* Idle mode on/off */
+    TTFT_SendCommand(
+        DeviceHandle,
+        ( On == true ) ? 0x39 : 0x38
+    );
+
+    DeviceHandle->IsIdle = On;
+}
+
+/*
+ * TTFT_EncodeColor:
+ * Converts a 24 bit colour into the bytes sent to the display, first byte in the lowest bits.
+ */
+static uint32_t TTFT_EncodeColor( TTFT_PixelFormat Format, Color_t Color ) {
+    uint32_t r = ( Color >> 16 ) & 0xFF;
+    uint32_t g = ( Color >> 8 ) & 0xFF;
+    uint32_t b = Color & 0xFF;
+
+    if ( Format == TTFT_PixelFormat_RGB666 ) {
+        /* 6 bits per channel in the top of each byte */
+        return ( r & 0xFC ) | ( ( g & 0xFC ) << 8 ) | ( ( b & 0xFC ) << 16 );
+    }
+
+    return __builtin_bswap16( ( ( r >> 3 ) << 11 ) | ( ( g >> 2 ) << 5 ) | ( b >> 3 ) );
+}
+
+/*
+ * TTFT_BuildWirePalette:
+ * Converts the whole palette to the current pixel format.
+ */
+static void TTFT_BuildWirePalette( struct TTFT_Device* DeviceHandle ) {
+    int i = 0;
+
+    for ( i = 0; i < 256; i++ ) {
+        DeviceHandle->WirePalette[ i ] = TTFT_EncodeColor( DeviceHandle->PixelFormat, DeviceHandle->Palette[ i ] );
+    }
+
+    DeviceHandle->WirePaletteFormat = DeviceHandle->PixelFormat;
+}
+
+/*
+ * TTFT_SetPixelFormat:
+ * Changes the pixel format sent to the display.
+ */
+void TTFT_SetPixelFormat( struct TTFT_Device* DeviceHandle, TTFT_PixelFormat Format ) {
+    NullCheck( DeviceHandle, return );
+
+    if ( Format != TTFT_PixelFormat_RGB565 && Format != TTFT_PixelFormat_RGB666 ) {
+        ESP_LOGE( __FUNCTION__, "Unsupported pixel format 0x%02X", Format );
+        return;
+    }
+
+    if ( TTFT_WaitReady( DeviceHandle, portMAX_DELAY ) == false ) {
+        return;
+    }
+
+    /* Pixel format */
+    TTFT_SendCommand(
+        DeviceHandle,
+        0x3A,
+        Format
+    );
+
+    DeviceHandle->PixelFormat = Format;
+    TTFT_BuildWirePalette( DeviceHandle );
+}
+
+/*
+ * TTFT_SetPalette:
+ * Sets the given alette as the new palette used to convert from indexed colour during updates.
+ * (NewPaletteSize) is in bytes.
+ */
+void TTFT_SetPalette( struct TTFT_Device* DeviceHandle, const Color_t* NewPalette, size_t NewPaletteSize ) {
+    NullCheck( DeviceHandle, return );
+    NullCheck( NewPalette, return );
+
+    NewPaletteSize = ( NewPaletteSize > sizeof( DeviceHandle->Palette ) ) ? sizeof( DeviceHandle->Palette ) : NewPaletteSize;
+
+    memcpy( DeviceHandle->Palette, NewPalette, NewPaletteSize );
+    TTFT_BuildWirePalette( DeviceHandle );
+}
+
+/*
+ * TTFT_SetPaletteEntry:
+ * Sets a single entry in the palette to the given RGB values.
+ */
+void TTFT_SetPaletteEntry( struct TTFT_Device* DeviceHandle, uint8_t Index, uint8_t Red, uint8_t Green, uint8_t Blue ) {
+    Color_t Color = RGB( Red, Green, Blue );
+
+    NullCheck( DeviceHandle, return );
+
+    DeviceHandle->Palette[ Index ] = Color;
+    DeviceHandle->WirePalette[ Index ] = TTFT_EncodeColor( DeviceHandle->WirePaletteFormat, Color );
+}
+
+/*
+ * TTFT_Clear:
+ * Clears the entire screen with the given colour index.
+ */
+void TTFT_Clear( struct TTFT_Device* DeviceHandle, uint8_t Color ) {
+    TTFT_Profile( TTFT_Profile_Clear );
+
+    NullCheck( DeviceHandle, return );
+    CheckDrawTarget( DeviceHandle, return );
+
+    TTFT_ProfilePixels( DeviceHandle->Width * DeviceHandle->Height );
+
+    if ( DeviceHandle->IsImmediate == true ) {
+        TTFT_PanelFillRect( DeviceHandle, 0, 0, DeviceHandle->Width - 1, DeviceHandle->Height - 1, Color );
+        return;
+    }
+
+    memset( DeviceHandle->FrameBuffer, Color, DeviceHandle->Width * DeviceHandle->Height );
+    TTFT_MarkDirty( DeviceHandle, 0, 0, DeviceHandle->Width - 1, DeviceHandle->Height - 1 );
+}
+
+/*
+ * TTFT_PutPixel:
+ * Draws a single pixel at the given x,y coordinates.
  */
 void IRAM_ATTR TTFT_PutPixel( struct TTFT_Device* DeviceHandle, int x, int y, uint8_t Color ) {
+    TTFT_Profile( TTFT_Profile_PutPixel );
+
     NullCheck( DeviceHandle, return );
-    NullCheck( DeviceHandle->FrameBuffer, return );
+    CheckDrawTarget( DeviceHandle, return );
 
     CheckBounds( x, 0, DeviceHandle->Width - 1, return );
     CheckBounds( y, 0, DeviceHandle->Height - 1, return );
 
-    TTFT_SetPixel( DeviceHandle, x, y, Color );
+    TTFT_ProfilePixels( 1 );
+
+    TTFT_FillSpan( DeviceHandle, x, y, x, y, Color );
+    TTFT_MarkDirty( DeviceHandle, x, y, x, y );
+}
+
+/*
+ * TTFT_FillSpan:
+ * Fills an onscreen rectangle in the framebuffer, or on the display in immediate mode.
+ * Colour 255 is transparent and draws nothing.
+ */
+static void IRAM_ATTR TTFT_FillSpan( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1, uint8_t Color ) {
+    if ( Color == 255 ) {
+        return;
+    }
+
+    if ( DeviceHandle->IsImmediate == true ) {
+        TTFT_PanelFillRect( DeviceHandle, x0, y0, x1, y1, Color );
+        return;
+    }
+
+    for ( ; y0 <= y1; y0++ ) {
+        memset( &DeviceHandle->FrameBuffer[ ( y0 * DeviceHandle->Width ) + x0 ], Color, ( x1 - x0 ) + 1 );
+    }
 }
 
 /*
@@ -545,16 +880,19 @@ void IRAM_ATTR TTFT_PutPixel( struct TTFT_Device* DeviceHandle, int x, int y, ui
  * Draws a horizontal line from (x0) to (x1)
  */
 void IRAM_ATTR TTFT_DrawHLine( struct TTFT_Device* DeviceHandle, int x0, int y, int x1, uint8_t Color ) {
+    TTFT_Profile( TTFT_Profile_DrawHLine );
+
     NullCheck( DeviceHandle, return );
-    NullCheck( DeviceHandle->FrameBuffer, return );
+    CheckDrawTarget( DeviceHandle, return );
 
     CheckBounds( x0, 0, DeviceHandle->Width - 1, return );  // Start x coord is on screen?
     CheckBounds( x1, x0, DeviceHandle->Width - 1, return ); // End x coord is greater than start coord and on screen?
     CheckBounds( y, 0, DeviceHandle->Height - 1, return );  // Start y coord is on screen?
 
-    for ( ; x0 <= x1; x0++ ) {
-        TTFT_SetPixel( DeviceHandle, x0, y, Color );
-    }
+    TTFT_ProfilePixels( ( x1 - x0 ) + 1 );
+
+    TTFT_MarkDirty( DeviceHandle, x0, y, x1, y );
+    TTFT_FillSpan( DeviceHandle, x0, y, x1, y, Color );
 }
 
 /*
@@ -562,16 +900,19 @@ void IRAM_ATTR TTFT_DrawHLine( struct TTFT_Device* DeviceHandle, int x0, int y,
  * Draws a vertical line from (y0) to (y1)
  */
 void IRAM_ATTR TTFT_DrawVLine( struct TTFT_Device* DeviceHandle, int x0, int y0, int y1, uint8_t Color ) {
+    TTFT_Profile( TTFT_Profile_DrawVLine );
+
     NullCheck( DeviceHandle, return );
-    NullCheck( DeviceHandle->FrameBuffer, return );
+    CheckDrawTarget( DeviceHandle, return );
 
     CheckBounds( x0, 0, DeviceHandle->Width - 1, return );
     CheckBounds( y0, 0, DeviceHandle->Height - 1, return );
     CheckBounds( y1, y0, DeviceHandle->Height - 1, return );
 
-    for ( ; y0 <= y1; y0++ ) {
-        TTFT_SetPixel( DeviceHandle, x0, y0, Color );
-    }
+    TTFT_ProfilePixels( ( y1 - y0 ) + 1 );
+
+    TTFT_MarkDirty( DeviceHandle, x0, y0, x0, y1 );
+    TTFT_FillSpan( DeviceHandle, x0, y0, x0, y1, Color );
 }
 
 static void IRAM_ATTR TTFT_DrawWideLine( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1, uint8_t Color ) {
@@ -579,6 +920,7 @@ static void IRAM_ATTR TTFT_DrawWideLine( struct TTFT_Device* DeviceHandle, int x
     int dy = ( y1 - y0 );
     int Error = 0;
     int Incr = 1;
+    int RunX = x0;
     int x = x0;
     int y = y0;
 
@@ -589,16 +931,22 @@ static void IRAM_ATTR TTFT_DrawWideLine( struct TTFT_Device* DeviceHandle, int x
 
     Error = ( dy * 2 ) - dx;
 
+    /* Pixels are drawn as horizontal runs, one per row the line passes through */
     for ( ; x <= x1; x++ ) {
-        TTFT_SetPixel( DeviceHandle, x, y, Color );
-
         if ( Error > 0 ) {
+            TTFT_FillSpan( DeviceHandle, RunX, y, x, y, Color );
+            RunX = x + 1;
+
             Error-= ( dx * 2 );
             y+= Incr;
         }
 
         Error+= ( dy * 2 );
     }
+
+    if ( RunX <= x1 ) {
+        TTFT_FillSpan( DeviceHandle, RunX, y, x1, y, Color );
+    }
 }
 
 static void IRAM_ATTR TTFT_DrawTallLine( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1, uint8_t Color ) {
@@ -606,6 +954,7 @@ static void IRAM_ATTR TTFT_DrawTallLine( struct TTFT_Device* DeviceHandle, int x
     int dy = ( y1 - y0 );
     int Error = 0;
     int Incr = 1;
+    int RunY = y0;
     int x = x0;
     int y = y0;
 
@@ -616,16 +965,22 @@ static void IRAM_ATTR TTFT_DrawTallLine( struct TTFT_Device* DeviceHandle, int x
 
     Error = ( dx * 2 ) - dy;
 
+    /* Pixels are drawn as vertical runs, one per column the line passes through */
     for ( ; y < y1; y++ ) {
-        TTFT_SetPixel( DeviceHandle, x, y, Color );
-
         if ( Error > 0 ) {
+            TTFT_FillSpan( DeviceHandle, x, RunY, x, y, Color );
+            RunY = y + 1;
+
             Error-= ( dy * 2 );
             x+= Incr;
         }
 
         Error+= ( dx * 2 );
     }
+
+    if ( RunY < y1 ) {
+        TTFT_FillSpan( DeviceHandle, x, RunY, x, y1 - 1, Color );
+    }
 }
 
 /*
@@ -633,10 +988,17 @@ static void IRAM_ATTR TTFT_DrawTallLine( struct TTFT_Device* DeviceHandle, int x
  * Draws a line between two points with the given colour index.
  */
 void IRAM_ATTR TTFT_DrawLine( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1, uint8_t Color ) {
+    TTFT_Profile( TTFT_Profile_DrawLine );
+
     NullCheck( DeviceHandle, return );
+    CheckDrawTarget( DeviceHandle, return );
 
     CheckBounds( x0, 0, DeviceHandle->Width - 1, return );
     CheckBounds( y0, 0, DeviceHandle->Height - 1, return );
+    CheckBounds( x1, 0, DeviceHandle->Width - 1, return );
+    CheckBounds( y1, 0, DeviceHandle->Height - 1, return );
+
+    TTFT_ProfilePixels( ( ( abs( x1 - x0 ) > abs( y1 - y0 ) ) ? abs( x1 - x0 ) : abs( y1 - y0 ) ) + 1 );
 
     if ( x0 == x1 ) {
         /* This is a vertical line, call the faster vertical line function instead */
@@ -654,6 +1016,7 @@ void IRAM_ATTR TTFT_DrawLine( struct TTFT_Device* DeviceHandle, int x0, int y0,
                 SwapInt( &y0, &y1 );
             }
 
+            TTFT_MarkDirty( DeviceHandle, x0, ( y0 < y1 ) ? y0 : y1, x1, ( y0 < y1 ) ? y1 : y0 );
             TTFT_DrawWideLine( DeviceHandle, x0, y0, x1, y1, Color );
         }
         else {
@@ -662,6 +1025,7 @@ void IRAM_ATTR TTFT_DrawLine( struct TTFT_Device* DeviceHandle, int x0, int y0,
                 SwapInt( &y0, &y1 );
             }
 
+            TTFT_MarkDirty( DeviceHandle, ( x0 < x1 ) ? x0 : x1, y0, ( x0 < x1 ) ? x1 : x0, y1 );
             TTFT_DrawTallLine( DeviceHandle, x0, y0, x1, y1, Color );
         }
     }
@@ -672,11 +1036,10 @@ void IRAM_ATTR TTFT_DrawLine( struct TTFT_Device* DeviceHandle, int x0, int y0,
  * Fills a section of the screen with the given colour.
  */
 void IRAM_ATTR TTFT_FillRect( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1, uint8_t Color ) {
-    int Width = ( x1 - x0 ) + 1;
-    int x = 0;
+    TTFT_Profile( TTFT_Profile_FillRect );
 
     NullCheck( DeviceHandle, return );
-    NullCheck( DeviceHandle->FrameBuffer, return );
+    CheckDrawTarget( DeviceHandle, return );
 
     CheckBounds( x0, 0, DeviceHandle->Width - 1, return );
     CheckBounds( y0, 0, DeviceHandle->Height - 1, return );
@@ -684,11 +1047,10 @@ void IRAM_ATTR TTFT_FillRect( struct TTFT_Device* DeviceHandle, int x0, int y0,
     CheckBounds( x1, x0, DeviceHandle->Width - 1, return );
     CheckBounds( y1, y0, DeviceHandle->Height - 1, return );
 
-    for ( ; y0 <= y1; y0++ ) {
-        for ( x = x0; x < ( x0 + Width ); x++ ) {
-            TTFT_SetPixel( DeviceHandle, x, y0, Color );
-        }
-    }
+    TTFT_ProfilePixels( ( ( x1 - x0 ) + 1 ) * ( ( y1 - y0 ) + 1 ) );
+
+    TTFT_MarkDirty( DeviceHandle, x0, y0, x1, y1 );
+    TTFT_FillSpan( DeviceHandle, x0, y0, x1, y1, Color );
 }
 
 /*
@@ -698,8 +1060,10 @@ void IRAM_ATTR TTFT_FillRect( struct TTFT_Device* DeviceHandle, int x0, int y0,
 void IRAM_ATTR TTFT_DrawBox( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1, int Thickness, uint8_t Color ) {
     int i = 0;
 
+    TTFT_Profile( TTFT_Profile_DrawBox );
+
     NullCheck( DeviceHandle, return );
-    NullCheck( DeviceHandle->FrameBuffer, return );
+    CheckDrawTarget( DeviceHandle, return );
 
     CheckBounds( x0, 0, DeviceHandle->Width - 1, return );
     CheckBounds( y0, 0, DeviceHandle->Height - 1, return );
@@ -707,6 +1071,9 @@ void IRAM_ATTR TTFT_DrawBox( struct TTFT_Device* DeviceHandle, int x0, int y0, i
     CheckBounds( x1, x0, DeviceHandle->Width - 1, return );
     CheckBounds( y1, y0, DeviceHandle->Height - 1, return );
 
+    /* Every line drawn, corners get drawn twice */
+    TTFT_ProfilePixels( ( ( x1 - x0 ) + ( y1 - y0 ) + 2 ) * 2 * Thickness );
+
     for ( i = 0; i < Thickness; i++ ) {
         /* Top */
         TTFT_DrawHLine( DeviceHandle, x0, y0 + i, x1, Color );
@@ -722,24 +1089,309 @@ void IRAM_ATTR TTFT_DrawBox( struct TTFT_Device* DeviceHandle, int x0, int y0, i
     }
 }
 
+/*
+ * TTFT_DrawBitmap:
+ * Copies a (Width) x (Height) block of colour indices to (x,y), clipped to the screen.
+ * Index 255 is copied like any other.
+ */
+void IRAM_ATTR TTFT_DrawBitmap( struct TTFT_Device* DeviceHandle, int x, int y, int Width, int Height, const uint8_t* Pixels ) {
+    int Col0 = 0;
+    int Col1 = 0;
+    int Row0 = 0;
+    int Row1 = 0;
+    int Row = 0;
+
+    TTFT_Profile( TTFT_Profile_DrawBitmap );
+
+    NullCheck( DeviceHandle, return );
+    NullCheck( Pixels, return );
+    CheckDrawTarget( DeviceHandle, return );
+
+    Col0 = ( x < 0 ) ? -x : 0;
+    Row0 = ( y < 0 ) ? -y : 0;
+    Col1 = ( x + Width > DeviceHandle->Width ) ? DeviceHandle->Width - x : Width;
+    Row1 = ( y + Height > DeviceHandle->Height ) ? DeviceHandle->Height - y : Height;
+
+    if ( Col0 >= Col1 || Row0 >= Row1 ) {
+        return;
+    }
+
+    TTFT_ProfilePixels( ( Col1 - Col0 ) * ( Row1 - Row0 ) );
+
+    if ( DeviceHandle->IsImmediate == true ) {
+        TTFT_PanelSetWindow( DeviceHandle, x + Col0, y + Row0, x + Col1 - 1, y + Row1 - 1 );
+
+        for ( Row = Row0; Row < Row1; Row++ ) {
+            TTFT_PanelWritePixels( DeviceHandle, &Pixels[ ( Row * Width ) + Col0 ], Col1 - Col0 );
+        }
+
+        return;
+    }
+
+    TTFT_MarkDirty( DeviceHandle, x + Col0, y + Row0, x + Col1 - 1, y + Row1 - 1 );
+
+    for ( Row = Row0; Row < Row1; Row++ ) {
+        memcpy( &DeviceHandle->FrameBuffer[ ( ( y + Row ) * DeviceHandle->Width ) + x + Col0 ], &Pixels[ ( Row * Width ) + Col0 ], Col1 - Col0 );
+    }
+}
+
+/*
+ * TTFT_SendSolid:
+ * Sends (Count) pixels of one colour to the current address window by filling the fill buffer
+ * once and queueing it over and over.
+ * Returns false if a transfer could not be queued, the window was left short.
+ */
+static bool IRAM_ATTR TTFT_SendSolid( struct TTFT_Device* DeviceHandle, uint8_t Color, int Count ) {
+    uint32_t WireColor = 0;
+    int BytesPerPixel = 0;
+    int InFlight = 0;
+    int Filled = 0;
+    int Pixels = 0;
+    int i = 0;
+
+    NullCheck( DeviceHandle->FillBuffer, return false );
+
+    /* Results are collected below, nothing else can be in the queue */
+    TTFT_SPIWaitQueued( DeviceHandle, 0 );
+
+    WireColor = TTFT_EncodeColor( DeviceHandle->PixelFormat, DeviceHandle->Palette[ Color ] );
+    BytesPerPixel = ( DeviceHandle->PixelFormat == TTFT_PixelFormat_RGB666 ) ? 3 : 2;
+
+    Pixels = ( Count > TTFT_FillBufferPixels ) ? TTFT_FillBufferPixels : Count;
+    memcpy( DeviceHandle->FillBuffer, &WireColor, BytesPerPixel );
+
+    /* Double the filled part each time */
+    for ( i = 1; i < Pixels; i+= Filled ) {
+        Filled = ( i < Pixels - i ) ? i : Pixels - i;
+        memcpy( &DeviceHandle->FillBuffer[ i * BytesPerPixel ], DeviceHandle->FillBuffer, Filled * BytesPerPixel );
+    }
+
+    /* The same buffer goes out as many times as needed, keeping the queue full */
+    for ( ; Count > 0; Count-= Pixels ) {
+        Pixels = ( Count > TTFT_FillBufferPixels ) ? TTFT_FillBufferPixels : Count;
+
+        if ( InFlight == PanelQueueDepth ) {
+            TTFT_WaitTransfer( DeviceHandle );
+            InFlight--;
+        }
+
+        if ( TTFT_QueueTransfer( DeviceHandle, DeviceHandle->FillBuffer, Pixels * BytesPerPixel ) == false ) {
+            ESP_LOGE( __FUNCTION__, "Failed to queue solid run, %d pixels not sent", Count );
+            break;
+        }
+
+        InFlight++;
+    }
+
+    for ( ; InFlight > 0; InFlight-- ) {
+        TTFT_WaitTransfer( DeviceHandle );
+    }
+
+    return Count <= 0;
+}
+
+/*
+ * TTFT_PanelFillRect:
+ * Fills a rectangle directly in display memory by sending the fill buffer over and over.
+ * Used by immediate mode but works on any device, the framebuffer is not touched.
+ */
+void IRAM_ATTR TTFT_PanelFillRect( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1, uint8_t Color ) {
+    TTFT_Profile( TTFT_Profile_PanelFillRect );
+
+    NullCheck( DeviceHandle, return );
+
+    CheckBounds( x0, 0, x1, return );
+    CheckBounds( x1, x0, DeviceHandle->Width - 1, return );
+    CheckBounds( y0, 0, y1, return );
+    CheckBounds( y1, y0, DeviceHandle->Height - 1, return );
+
+    TTFT_ProfilePixels( ( ( x1 - x0 ) + 1 ) * ( ( y1 - y0 ) + 1 ) );
+
+    TTFT_AcquireBus( DeviceHandle );
+
+    TTFT_PanelSetWindow( DeviceHandle, x0, y0, x1, y1 );
+    TTFT_SendSolid( DeviceHandle, Color, ( ( x1 - x0 ) + 1 ) * ( ( y1 - y0 ) + 1 ) );
+
+    TTFT_ReleaseBus( DeviceHandle );
+}
+
+/*
+ * TTFT_PanelSetWindow:
+ * Starts a write of the given rectangle directly to display memory, fill it with TTFT_PanelWritePixels.
+ */
+void IRAM_ATTR TTFT_PanelSetWindow( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1 ) {
+    NullCheck( DeviceHandle, return );
+
+    if ( TTFT_WaitReady( DeviceHandle, portMAX_DELAY ) == false ) {
+        return;
+    }
+
+    TTFT_SetAddressWindow( DeviceHandle, x0, y0, x1, y1 );
+}
+
+/*
+ * TTFT_PanelWritePixels:
+ * Converts (Count) colour indices and sends them to the window set by TTFT_PanelSetWindow.
+ */
+void IRAM_ATTR TTFT_PanelWritePixels( struct TTFT_Device* DeviceHandle, const uint8_t* Pixels, int Count ) {
+    int BytesPerPixel = 0;
+    int Chunk = 0;
+
+    NullCheck( DeviceHandle, return );
+    NullCheck( Pixels, return );
+
+    NullCheck( DeviceHandle->FillBuffer, return );
+
+    if ( DeviceHandle->WirePaletteFormat != DeviceHandle->PixelFormat ) {
+        TTFT_BuildWirePalette( DeviceHandle );
+    }
+
+    BytesPerPixel = ( DeviceHandle->PixelFormat == TTFT_PixelFormat_RGB666 ) ? 3 : 2;
+
+    for ( ; Count > 0; Count-= Chunk, Pixels+= Chunk ) {
+        Chunk = ( Count > TTFT_FillBufferPixels ) ? TTFT_FillBufferPixels : Count;
+
+        if ( BytesPerPixel == 3 ) {
+            TTFT_ConvertRow666( DeviceHandle->WirePalette, Pixels, DeviceHandle->FillBuffer, Chunk );
+        }
+        else {
+            TTFT_ConvertRow565( DeviceHandle->WirePalette, Pixels, DeviceHandle->FillBuffer, Chunk );
+        }
+
+        TTFT_SPIWrite( DeviceHandle, DeviceHandle->FillBuffer, Chunk * BytesPerPixel, false );
+    }
+}
+
+/*
+ * TTFT_TraceQueued:
+ * Adds a transfer handed to the transport at (Now) to the trace, if there is one.
+ * Only the task updating the display writes entries, readers see them once (TraceHead) moves past.
+ */
+static inline void TTFT_TraceQueued( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t DataLength, bool IsCommand, int64_t Now ) {
+    struct TTFT_TraceEntry* Trace = __atomic_load_n( &DeviceHandle->Trace, __ATOMIC_ACQUIRE );
+    struct TTFT_TraceEntry* Entry = NULL;
+    uint32_t Head = DeviceHandle->TraceHead;
+
+    if ( Trace != NULL ) {
+        Entry = &Trace[ Head % DeviceHandle->TraceSize ];
+
+        Entry->Queued = Now;
+        Entry->Completed = 0;
+        Entry->Length = DataLength;
+        Entry->IsCommand = IsCommand;
+        Entry->FirstByte = Data[ 0 ];
+
+        __atomic_store_n( &DeviceHandle->TraceHead, Head + 1, __ATOMIC_RELEASE );
+    }
+}
+
+/*
+ * TTFT_TraceCompleted:
+ * Marks the oldest transfer in the trace that isn't done yet as done at (Now).
+ * Transfers finish in the order they were queued.
+ * (Completed) is 64 bits and can't be written in one go on the ESP32,
+ * readers only trust it once (TraceDone) moves past.
+ */
+static inline void TTFT_TraceCompleted( struct TTFT_Device* DeviceHandle, int64_t Now ) {
+    struct TTFT_TraceEntry* Trace = __atomic_load_n( &DeviceHandle->Trace, __ATOMIC_ACQUIRE );
+    uint32_t Done = DeviceHandle->TraceDone;
+
+    if ( Trace != NULL && Done != DeviceHandle->TraceHead ) {
+        Trace[ Done % DeviceHandle->TraceSize ].Completed = Now;
+
+        __atomic_store_n( &DeviceHandle->TraceDone, Done + 1, __ATOMIC_RELEASE );
+    }
+}
+
+/*
+ * TTFT_QueueTransfer:
+ * Queues (DataLength) bytes of pixel data with the transport and counts them for the flush statistics.
+ */
+static inline bool TTFT_QueueTransfer( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t DataLength ) {
+    int64_t Now = ( DeviceHandle->Trace != NULL ) ? esp_timer_get_time( ) : 0;
+
+    if ( DeviceHandle->Ops->Queue( DeviceHandle, Data, DataLength, false ) == false ) {
+        return false;
+    }
+
+    TTFT_TraceQueued( DeviceHandle, Data, DataLength, false, Now );
+
+    DeviceHandle->FlushBytes+= DataLength;
+    DeviceHandle->FlushTransactions++;
+
+    return true;
+}
+
+/*
+ * TTFT_WaitTransfer:
+ * Waits for the oldest queued transfer and counts the time for the flush statistics.
+ */
+static inline void TTFT_WaitTransfer( struct TTFT_Device* DeviceHandle ) {
+    int64_t Start = esp_timer_get_time( );
+    int64_t End = 0;
+
+    DeviceHandle->Ops->Wait( DeviceHandle );
+    End = esp_timer_get_time( );
+
+    DeviceHandle->FlushWaitTime+= End - Start;
+    TTFT_TraceCompleted( DeviceHandle, End );
+}
+
+/*
+ * TTFT_SPIWaitQueued:
+ * Waits until no more than (MaxQueued) update chunks are still queued.
+ */
+static void IRAM_ATTR TTFT_SPIWaitQueued( struct TTFT_Device* DeviceHandle, int MaxQueued ) {
+    for ( ; DeviceHandle->QueuedCount > MaxQueued; DeviceHandle->QueuedCount-- ) {
+        TTFT_WaitTransfer( DeviceHandle );
+    }
+}
+
+/*
+ * TTFT_SPIWriteQueued:
+ * Queues (DataLength) bytes of pixel data and returns without waiting.
+ * (Data) must be left alone until TTFT_SPIWaitQueued says it's gone out.
+ */
+static void IRAM_ATTR TTFT_SPIWriteQueued( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t DataLength ) {
+    TTFT_SPIWaitQueued( DeviceHandle, TTFT_QueuedTransfers - 1 );
+
+    if ( TTFT_QueueTransfer( DeviceHandle, Data, DataLength ) == true ) {
+        DeviceHandle->QueuedCount++;
+    }
+}
+
+/*
+ * TTFT_SPIWrite:
+ * Sends (DataLength) bytes as a command or data and waits for them to go out, see TTFT_SetTransport.
+ */
 void TTFT_SPIWrite( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t DataLength, bool IsCommand ) {
-    spi_transaction_t SPITrans;
-    int User = 0;
+    int64_t Start = 0;
+    int64_t End = 0;
+    bool Poll = false;
 
     NullCheck( DeviceHandle, return );
     NullCheck( Data, return );
 
     if ( DataLength > 0 ) {
-        memset( &SPITrans, 0, sizeof( SPITrans ) );
+        /* Anything queued by an update has to go out first */
+        TTFT_SPIWaitQueued( DeviceHandle, 0 );
+
+        /* Polling skips the interrupt and context switch, which is most of the time for small transfers */
+        Poll = ( DeviceHandle->Transport == TTFT_Transport_Polling );
+        Poll = Poll || ( DeviceHandle->Transport == TTFT_Transport_Auto && DataLength <= DeviceHandle->PollingThreshold );
 
-        User = ( IsCommand == false ) ? ( 1 << 8 ) : 0;
-        User |= DeviceHandle->DCPin;
+        /* Blocking writes are all waiting as far as the flush statistics go */
+        Start = esp_timer_get_time( );
+        DeviceHandle->Ops->Write( DeviceHandle, Data, DataLength, IsCommand, Poll );
+        End = esp_timer_get_time( );
 
-        SPITrans.length = DataLength * 8;
-        SPITrans.user = ( void* ) MakeUser( DeviceHandle->DCPin, ( IsCommand == true ) ? 0 : 1 );
-        SPITrans.tx_buffer = Data;
+        /* Everything queued went out first, so this is the oldest transfer not done */
+        TTFT_TraceQueued( DeviceHandle, Data, DataLength, IsCommand, Start );
+        TTFT_TraceCompleted( DeviceHandle, End );
 
-        ESP_ERROR_CHECK_NONFATAL( spi_device_transmit( DeviceHandle->Handle, &SPITrans ), return );
+        DeviceHandle->FlushWaitTime+= End - Start;
+        DeviceHandle->FlushBytes+= DataLength;
+        DeviceHandle->FlushTransactions++;
     }
 }
 
@@ -749,6 +1401,12 @@ void TTFT_SPIWrite( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_
  */
 #define LineUpdateCount 4
 
+/*
+ * Runs of single colour rows at least this many pixels long are sent
+ * from the fill buffer instead of being converted a pixel at a time.
+ */
+#define SolidRunMinPixels 256
+
 /*
  * TTFT_Update:
  * Converts the 8bit indexed shadow framebuffer to RGB (LineUpdateCount)
@@ -758,31 +1416,360 @@ void TTFT_SPIWrite( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_
  * A higher LineUpdateCount might speed things up but will use more memory.
  */
 void IRAM_ATTR TTFT_Update( struct TTFT_Device* DeviceHandle ) {
-    Color_t* LineBuffer = NULL;
+    TTFT_Profile( TTFT_Profile_Update );
+
+    NullCheck( DeviceHandle, return );
+    TTFT_ProfilePixels( DeviceHandle->Width * DeviceHandle->Height );
+
+    /* Cleared first, TTFT_UpdateRect marks the screen dirty again if it fails */
+    TTFT_ClearDirty( DeviceHandle );
+    TTFT_UpdateRect( DeviceHandle, 0, 0, DeviceHandle->Width - 1, DeviceHandle->Height - 1 );
+}
+
+/*
+ * TTFT_ConvertRow565:
+ * Converts (Count) indexed pixels to RGB565, two pixels per 32 bit store once (Out) is aligned.
+ */
+static void IRAM_ATTR TTFT_ConvertRow565( const uint32_t* Palette, const uint8_t* In, uint8_t* Out, int Count ) {
+    uint16_t* Out16 = ( uint16_t* ) Out;
+    uint32_t* Out32 = NULL;
+
+    if ( ( ( uintptr_t ) Out16 & 3 ) != 0 && Count > 0 ) {
+        *Out16++ = Palette[ *In++ ];
+        Count--;
+    }
+
+    for ( Out32 = ( uint32_t* ) Out16; Count >= 2; Count-= 2, In+= 2 ) {
+        *Out32++ = Palette[ In[ 0 ] ] | ( Palette[ In[ 1 ] ] << 16 );
+    }
+
+    if ( Count > 0 ) {
+        *( ( uint16_t* ) Out32 ) = Palette[ *In ];
+    }
+}
+
+/*
+ * TTFT_ConvertRow666:
+ * Converts (Count) indexed pixels to RGB666, packing four 3 byte pixels into three 32 bit stores
+ * once (Out) is aligned.
+ */
+static void IRAM_ATTR TTFT_ConvertRow666( const uint32_t* Palette, const uint8_t* In, uint8_t* Out, int Count ) {
+    uint32_t* Out32 = NULL;
+    uint32_t A = 0;
+    uint32_t B = 0;
+    uint32_t C = 0;
+    uint32_t D = 0;
+
+    /* At most 3 pixels until the output is word aligned */
+    for ( ; ( ( uintptr_t ) Out & 3 ) != 0 && Count > 0; Count--, Out+= 3 ) {
+        A = Palette[ *In++ ];
+
+        Out[ 0 ] = A;
+        Out[ 1 ] = A >> 8;
+        Out[ 2 ] = A >> 16;
+    }
+
+    for ( Out32 = ( uint32_t* ) Out; Count >= 4; Count-= 4, In+= 4, Out32+= 3 ) {
+        A = Palette[ In[ 0 ] ];
+        B = Palette[ In[ 1 ] ];
+        C = Palette[ In[ 2 ] ];
+        D = Palette[ In[ 3 ] ];
+
+        Out32[ 0 ] = A | ( B << 24 );
+        Out32[ 1 ] = ( B >> 8 ) | ( C << 16 );
+        Out32[ 2 ] = ( C >> 16 ) | ( D << 8 );
+    }
+
+    for ( Out = ( uint8_t* ) Out32; Count > 0; Count--, Out+= 3 ) {
+        A = Palette[ *In++ ];
+
+        Out[ 0 ] = A;
+        Out[ 1 ] = A >> 8;
+        Out[ 2 ] = A >> 16;
+    }
+}
+
+/*
+ * TTFT_CountSolidRows:
+ * Returns how many of the (Rows) rows of (LineWidth) pixels starting at (Row) are all one colour,
+ * which is stored in (OutColor). Returns 0 if the first row isn't a single colour.
+ */
+static int IRAM_ATTR TTFT_CountSolidRows( struct TTFT_Device* DeviceHandle, const uint8_t* Row, int LineWidth, int Rows, uint8_t* OutColor ) {
+    int Count = 0;
+
+    /* Each pixel equals the next, so the whole row is the colour of the first */
+    for ( ; Count < Rows; Count++, Row+= DeviceHandle->Width ) {
+        if ( Row[ 0 ] != *OutColor && Count > 0 ) {
+            break;
+        }
+
+        if ( memcmp( Row, Row + 1, LineWidth - 1 ) != 0 ) {
+            break;
+        }
+
+        *OutColor = Row[ 0 ];
+    }
+
+    return Count;
+}
+
+/*
+ * TTFT_SendChunk:
+ * Sends converted pixels from an update, queued if (Queue) is true.
+ */
+static inline void TTFT_SendChunk( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t DataLength, bool Queue ) {
+    if ( Queue == true ) {
+        TTFT_SPIWriteQueued( DeviceHandle, Data, DataLength );
+    }
+    else {
+        TTFT_SPIWrite( DeviceHandle, Data, DataLength, false );
+    }
+}
+
+/*
+ * TTFT_UpdateRect:
+ * Same as TTFT_Update but only sends the given rectangle of the framebuffer.
+ * Does not change the dirty rectangle unless sending fails, then the rectangle is marked dirty again.
+ * In partial mode only rows inside the partial area are sent.
+ * Runs of rows that are all one colour are sent from the fill buffer without converting them.
+ */
+void IRAM_ATTR TTFT_UpdateRect( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1 ) {
+    uint8_t* LineBuffer = NULL;
+    uint8_t* Chunk = NULL;
+    uint8_t* Out = NULL;
     uint8_t* Ptr = NULL;
+    uint8_t SolidColor = 0;
+    int64_t Start = 0;
+    int BytesPerPixel = 0;
+    size_t ChunkBytes = 0;
+    int SolidRows = 0;
     int LineWidth = 0;
-    int LineSize = 0;
-    int i = 0;
+    int Buffers = 1;
+    int Current = 0;
+    int Lines = 0;
     int y = 0;
 
+    TTFT_Profile( TTFT_Profile_UpdateRect );
+
     NullCheck( DeviceHandle, return );
+
+    /* Everything is already on the display in immediate mode */
+    if ( DeviceHandle->IsImmediate == true ) {
+        return;
+    }
     NullCheck( DeviceHandle->FrameBuffer, return );
 
-    LineWidth = DeviceHandle->Width;
-    LineSize = LineWidth * LineUpdateCount * sizeof( Color_t );
+    CheckBounds( x0, 0, x1, return );
+    CheckBounds( x1, x0, DeviceHandle->Width - 1, return );
+    CheckBounds( y0, 0, y1, return );
+    CheckBounds( y1, y0, DeviceHandle->Height - 1, return );
+
+    /* Rows outside the partial area aren't shown, don't waste time sending them */
+    x0 = ( x0 < DeviceHandle->PartialX0 ) ? DeviceHandle->PartialX0 : x0;
+    x1 = ( x1 > DeviceHandle->PartialX1 ) ? DeviceHandle->PartialX1 : x1;
+    y0 = ( y0 < DeviceHandle->PartialY0 ) ? DeviceHandle->PartialY0 : y0;
+    y1 = ( y1 > DeviceHandle->PartialY1 ) ? DeviceHandle->PartialY1 : y1;
+
+    if ( x0 > x1 || y0 > y1 ) {
+        return;
+    }
+
+    LineWidth = ( x1 - x0 ) + 1;
+    TTFT_ProfilePixels( LineWidth * ( ( y1 - y0 ) + 1 ) );
+
+    if ( TTFT_WaitReady( DeviceHandle, portMAX_DELAY ) == false ) {
+        return;
+    }
+
+    Start = esp_timer_get_time( );
+
+    DeviceHandle->FlushBytes = 0;
+    DeviceHandle->FlushTransactions = 0;
+    DeviceHandle->FlushWaitTime = 0;
+
+    /* The display may have changed format after the palette was set (ie. ILI9488 init) */
+    if ( DeviceHandle->WirePaletteFormat != DeviceHandle->PixelFormat ) {
+        TTFT_BuildWirePalette( DeviceHandle );
+    }
+
+    BytesPerPixel = ( DeviceHandle->PixelFormat == TTFT_PixelFormat_RGB666 ) ? 3 : 2;
+    ChunkBytes = LineWidth * LineUpdateCount * BytesPerPixel;
+
+    /* Queue chunks ahead so the next one is converted while the last one goes out */
+    if ( DeviceHandle->Transport == TTFT_Transport_Queued || ( DeviceHandle->Transport == TTFT_Transport_Auto && ChunkBytes > DeviceHandle->PollingThreshold ) ) {
+        Buffers = TTFT_QueuedTransfers;
+    }
+
+    NullCheck( ( LineBuffer = heap_caps_malloc( ChunkBytes * Buffers, MALLOC_CAP_DMA ) ), DeviceHandle->Stats.AllocFailures++; TTFT_MarkDirty( DeviceHandle, x0, y0, x1, y1 ); return );
 
-    NullCheck( ( LineBuffer = heap_caps_malloc( LineSize, MALLOC_CAP_DMA ) ), return );
+    /* Hold the bus for the whole update rather than each transaction arbitrating for it */
+    TTFT_AcquireBus( DeviceHandle );
+    TTFT_SetAddressWindow( DeviceHandle, x0, y0, x1, y1 );
 
-    TTFT_SetAddressWindow( DeviceHandle, 0, 0, DeviceHandle->Width - 1, DeviceHandle->Height - 1 );
-    Ptr = DeviceHandle->FrameBuffer;
+    for ( y = y0, Chunk = Out = LineBuffer; y <= y1; ) {
+        Ptr = &DeviceHandle->FrameBuffer[ ( y * DeviceHandle->Width ) + x0 ];
+        SolidRows = TTFT_CountSolidRows( DeviceHandle, Ptr, LineWidth, ( y1 - y ) + 1, &SolidColor );
 
-    for ( y = 0; y < DeviceHandle->Height; y+= LineUpdateCount ) {
-        for ( i = 0; i < LineWidth * LineUpdateCount; i++ ) {
-            LineBuffer[ i ] = DeviceHandle->Palette[ *Ptr++ ];
+        if ( SolidRows * LineWidth >= SolidRunMinPixels ) {
+            /* Rows already converted have to go first, the window is filled in order */
+            if ( Lines > 0 ) {
+                TTFT_SendChunk( DeviceHandle, Chunk, LineWidth * Lines * BytesPerPixel, Buffers > 1 );
+
+                Current = ( Current + 1 ) % Buffers;
+                Chunk = Out = &LineBuffer[ Current * ChunkBytes ];
+                Lines = 0;
+            }
+
+            /* Anything after a short run would land in the wrong place, stop and leave it for the next update */
+            if ( TTFT_SendSolid( DeviceHandle, SolidColor, SolidRows * LineWidth ) == false ) {
+                TTFT_MarkDirty( DeviceHandle, x0, y0, x1, y1 );
+                break;
+            }
+
+            TTFT_YieldBus( DeviceHandle );
+
+            y+= SolidRows;
+
+            continue;
         }
 
-        TTFT_SPIWrite( DeviceHandle, ( const uint8_t* ) LineBuffer, LineSize, false );
+        /* Don't convert into a chunk that is still queued */
+        if ( Lines == 0 && Buffers > 1 ) {
+            TTFT_SPIWaitQueued( DeviceHandle, Buffers - 1 );
+        }
+
+        if ( BytesPerPixel == 3 ) {
+            TTFT_ConvertRow666( DeviceHandle->WirePalette, Ptr, Out, LineWidth );
+        }
+        else {
+            TTFT_ConvertRow565( DeviceHandle->WirePalette, Ptr, Out, LineWidth );
+        }
+
+        Out+= LineWidth * BytesPerPixel;
+        Lines++;
+        y++;
+
+        if ( Lines == LineUpdateCount || y > y1 ) {
+            TTFT_SendChunk( DeviceHandle, Chunk, LineWidth * Lines * BytesPerPixel, Buffers > 1 );
+            TTFT_YieldBus( DeviceHandle );
+
+            Current = ( Current + 1 ) % Buffers;
+            Chunk = Out = &LineBuffer[ Current * ChunkBytes ];
+            Lines = 0;
+        }
     }
 
+    TTFT_SPIWaitQueued( DeviceHandle, 0 );
+    TTFT_ReleaseBus( DeviceHandle );
+
     heap_caps_free( LineBuffer );
+
+    TTFT_RecordFlush( DeviceHandle, LineWidth * ( ( y1 - y0 ) + 1 ), esp_timer_get_time( ) - Start );
+}
+
+/*
+ * TTFT_UpdateDirty:
+ * Sends only the area drawn to since the last update, if any.
+ */
+void IRAM_ATTR TTFT_UpdateDirty( struct TTFT_Device* DeviceHandle ) {
+    int x0 = 0;
+    int y0 = 0;
+    int x1 = 0;
+    int y1 = 0;
+
+    TTFT_Profile( TTFT_Profile_UpdateDirty );
+
+    NullCheck( DeviceHandle, return );
+
+    x0 = DeviceHandle->DirtyX0;
+    y0 = DeviceHandle->DirtyY0;
+    x1 = DeviceHandle->DirtyX1;
+    y1 = DeviceHandle->DirtyY1;
+
+    if ( x0 <= x1 ) {
+        TTFT_ProfilePixels( ( ( x1 - x0 ) + 1 ) * ( ( y1 - y0 ) + 1 ) );
+
+        /* Cleared first, TTFT_UpdateRect marks the area dirty again if it fails */
+        TTFT_ClearDirty( DeviceHandle );
+        TTFT_UpdateRect( DeviceHandle, x0, y0, x1, y1 );
+    }
+}
+
+/*
+ * TTFT_MarkDirty:
+ * Adds the given rectangle to the area sent by the next TTFT_UpdateDirty.
+ * Drawing functions do this themselves, this is only needed when writing to the framebuffer directly.
+ * Coordinates are clipped to the screen.
+ */
+void IRAM_ATTR TTFT_MarkDirty( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1 ) {
+    x0 = ( x0 < 0 ) ? 0 : x0;
+    y0 = ( y0 < 0 ) ? 0 : y0;
+    x1 = ( x1 >= DeviceHandle->Width ) ? DeviceHandle->Width - 1 : x1;
+    y1 = ( y1 >= DeviceHandle->Height ) ? DeviceHandle->Height - 1 : y1;
+
+    if ( x0 > x1 || y0 > y1 ) {
+        return;
+    }
+
+    DeviceHandle->DirtyX0 = ( x0 < DeviceHandle->DirtyX0 ) ? x0 : DeviceHandle->DirtyX0;
+    DeviceHandle->DirtyY0 = ( y0 < DeviceHandle->DirtyY0 ) ? y0 : DeviceHandle->DirtyY0;
+    DeviceHandle->DirtyX1 = ( x1 > DeviceHandle->DirtyX1 ) ? x1 : DeviceHandle->DirtyX1;
+    DeviceHandle->DirtyY1 = ( y1 > DeviceHandle->DirtyY1 ) ? y1 : DeviceHandle->DirtyY1;
+}
+
+/*
+ * TTFT_ClearDirty:
+ * Forgets about anything drawn since the last update.
+ */
+void TTFT_ClearDirty( struct TTFT_Device* DeviceHandle ) {
+    NullCheck( DeviceHandle, return );
+
+    DeviceHandle->DirtyX0 = DeviceHandle->Width;
+    DeviceHandle->DirtyY0 = DeviceHandle->Height;
+    DeviceHandle->DirtyX1 = -1;
+    DeviceHandle->DirtyY1 = -1;
+}
+
+/*
+ * TTFT_ArenaInit:
+ * Sets up an arena to hand out memory from the given buffer.
+ */
+void TTFT_ArenaInit( struct TTFT_Arena* Arena, void* Buffer, size_t Size ) {
+    NullCheck( Arena, return );
+    NullCheck( Buffer, return );
+
+    Arena->Base = ( uint8_t* ) Buffer;
+    Arena->Size = Size;
+    Arena->Used = 0;
+}
+
+/*
+ * TTFT_ArenaAlloc:
+ * Returns (Size) bytes from the arena aligned to 4 bytes, or NULL if the arena is full.
+ */
+void* TTFT_ArenaAlloc( struct TTFT_Arena* Arena, size_t Size ) {
+    size_t Start = 0;
+
+    NullCheck( Arena, return NULL );
+    NullCheck( Arena->Base, return NULL );
+
+    Start = ( Arena->Used + 3 ) & ~( ( size_t ) 3 );
+
+    if ( Size == 0 || Start + Size > Arena->Size ) {
+        return NULL;
+    }
+
+    Arena->Used = Start + Size;
+    return &Arena->Base[ Start ];
+}
+
+/*
+ * TTFT_ArenaReset:
+ * Releases every allocation made from the arena.
+ * Anything still pointing into it (labels, etc...) must be invalidated by the caller.
+ */
+void TTFT_ArenaReset( struct TTFT_Arena* Arena ) {
+    NullCheck( Arena, return );
+
+    Arena->Used = 0;
 }
@@ -8,6 +8,8 @@ extern "C" {
 #include <stdbool.h>
 #include <stdint.h>
 #include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
 
 #define REG_MADCTL 0x36
 
@@ -64,6 +66,16 @@ extern "C" {
     }
 #endif
 
+/* Drawing needs either a framebuffer or a device in immediate mode */
+#if ! defined CheckDrawTarget
+    #define CheckDrawTarget( DeviceHandle, retexpr ) { \
+        if ( ( DeviceHandle )->FrameBuffer == NULL && ( DeviceHandle )->IsImmediate == false ) { \
+            ESP_LOGE( __FUNCTION__, "No framebuffer to draw to" ); \
+            retexpr; \
+        } \
+    }
+#endif
+
 #define TTFT_SendCommand( DeviceHandle, Command, ... ) { \
     do { \
         const uint8_t Data[ ] = { __VA_ARGS__ }; \
@@ -71,38 +83,46 @@ extern "C" {
         \
         TTFT_SPIWrite( DeviceHandle, &CMD, sizeof( uint8_t ), true ); \
         TTFT_SPIWrite( DeviceHandle, Data, sizeof( Data ), false ); \
+        \
+        if ( CMD == REG_MADCTL && sizeof( Data ) > 0 ) { \
+            ( DeviceHandle )->AddressMode = Data[ 0 ]; \
+        } \
     } while ( false ); \
 }
 
-#define MakeUser( Pin, Command ) ( ( Pin | ( Command << 8 ) ) )
-
-//#define _18BIT_COLOR
-
-#if defined _18BIT_COLOR
-    typedef struct __attribute__( ( packed ) ) {
-        uint8_t r;
-        uint8_t g;
-        uint8_t b;
-    } Color_t;
-
-    #define PixelFormat 0x66
+/*
+ * Init tables are a list of commands in the form:
+ * Command, Parameter count | Flags, Parameters..., [Since ms], [Delay ms]
+ * and end with TTFT_InitEnd.
+ * The parameter of the pixel format command (0x3A) is replaced with the format of the device.
+ * 
+ * TTFT_InitDelay: Wait (Delay ms) after sending the command, this also starts the clock for TTFT_InitSince.
+ * TTFT_InitSince: Don't send the command until (Since ms) after the last command with TTFT_InitDelay.
+ */
+#define TTFT_InitDelay 0x80
+#define TTFT_InitSince 0x40
+#define TTFT_InitEndMarker 0xFF
+#define TTFT_InitEnd 0x00, TTFT_InitEndMarker
 
-    #define RGB( r, g, b ) { \
-        ( r & 0xFF ), \
-        ( g & 0xFF ), \
-        ( b & 0xFF ) \
-    }
-#else
-    typedef uint16_t Color_t;
+/*
+ * Palette entries are always 24 bit RGB, they get converted to the
+ * pixel format of the display when the palette is set.
+ */
+typedef uint32_t Color_t;
 
-    #define PixelFormat 0x55
+#define RGB( r, g, b ) ( \
+    ( ( ( r ) & 0xFF ) << 16 ) | \
+    ( ( ( g ) & 0xFF ) << 8 ) | \
+    ( ( b ) & 0xFF ) \
+)
 
-    #define RGB( r, g, b ) __builtin_bswap16( \
-        ( ( ( r & 0xFF ) >> 3 ) << 11 ) | \
-        ( ( ( g & 0xFF ) >> 2 ) << 5 ) | \
-        ( ( b & 0xFF ) >> 3 ) \
-    )
-#endif
+/*
+ * Pixel formats sent over the wire, values are what the COLMOD (0x3A) command takes.
+ */
+typedef enum {
+    TTFT_PixelFormat_RGB565 = 0x55,
+    TTFT_PixelFormat_RGB666 = 0x66
+} TTFT_PixelFormat;
 
 #define TTFT_SetPixel( DeviceHandle, x, y, Color ) { \
     do { \
@@ -113,6 +133,151 @@ extern "C" {
 } 
 
 struct TTFT_FontDef;
+struct TTFT_Device;
+struct TTFT_TraceEntry;
+
+/*
+ * Flags for TTFT_InitEx.
+ * 
+ * TTFT_InitFlag_Async: Return right away and reset the display in a background task,
+ * see TTFT_IsReady and TTFT_WaitReady.
+ * 
+ * TTFT_InitFlag_Resume: When waking from deep sleep after TTFT_Sleep skip the reset
+ * and init sequence, the display only gets sleep out and display on.
+ * The pixel format and MADCTL the display slept with are kept, even if TTFT_InitFlag_RGB666 disagrees.
+ * 
+ * TTFT_InitFlag_RGB666: Send 18 bit colour instead of 16 bit.
+ * 
+ * TTFT_InitFlag_NoFrameBuffer: Immediate mode, no framebuffer is allocated and drawing
+ * functions write straight to the display. Updates do nothing.
+ * 
+ * TTFT_InitFlag_ShareBus: Let other devices on the SPI bus (ie. SD cards) in between chunks
+ * of an update instead of holding the bus until it's done, see TTFT_SetBusSharing.
+ */
+typedef enum {
+    TTFT_InitFlag_Default = 0,
+    TTFT_InitFlag_Async = 1,
+    TTFT_InitFlag_Resume = 2,
+    TTFT_InitFlag_RGB666 = 4,
+    TTFT_InitFlag_NoFrameBuffer = 8,
+    TTFT_InitFlag_ShareBus = 16
+} TTFT_InitFlags;
+
+/*
+ * How data gets onto the bus, see TTFT_SetTransport.
+ * Only update chunks are ever queued, every other write waits for itself to go out.
+ * 
+ * TTFT_Transport_Auto: Writes up to the polling threshold (ie. commands) are polled,
+ * bigger ones are sent with spi_device_transmit. Update chunks bigger than the threshold are queued
+ * for DMA and the next one is converted while the last one goes out.
+ * 
+ * TTFT_Transport_Polling: Everything is sent with spi_device_polling_transmit, no interrupts.
+ * 
+ * TTFT_Transport_Interrupt: Everything is sent with spi_device_transmit, nothing is queued ahead.
+ * 
+ * TTFT_Transport_Queued: Writes are sent with spi_device_transmit, update chunks are always queued ahead.
+ */
+typedef enum {
+    TTFT_Transport_Auto = 0,
+    TTFT_Transport_Polling,
+    TTFT_Transport_Interrupt,
+    TTFT_Transport_Queued
+} TTFT_Transport;
+
+/* Transfers up to this many bytes are polled in TTFT_Transport_Auto unless changed by TTFT_SetTransport */
+#define TTFT_DefaultPollingThreshold 32
+
+/* Update chunks that can be queued ahead, each one has its own line buffer */
+#define TTFT_QueuedTransfers 2
+
+/* Writes a transport has to be able to have queued at once */
+#define TTFT_TransportQueueDepth 8
+
+/*
+ * Everything that talks to the display hardware goes through one of these, see TTFT_InitTransport.
+ * TTFT_ESP32SPI in ttft_spi.c drives the display over the ESP32 SPI master and
+ * TTFT_HostTransport in host/ttft_host.c decodes the commands into memory on a PC.
+ */
+struct TTFT_TransportOps {
+    /* Called by TTFT_InitTransport with its (Param), sets up TransportState */
+    bool ( *Open ) ( struct TTFT_Device* DeviceHandle, void* Param );
+    void ( *Close ) ( struct TTFT_Device* DeviceHandle );
+
+    /* Sends (Length) bytes with the D/C line set for a command or data and waits for them to go out, (Poll) asks not to use interrupts */
+    void ( *Write ) ( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t Length, bool IsCommand, bool Poll );
+
+    /*
+     * Queue starts a write and returns without waiting, up to TTFT_TransportQueueDepth can be queued and they go out in order.
+     * Wait waits for the oldest queued write, (Data) must be left alone until then.
+     */
+    bool ( *Queue ) ( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t Length, bool IsCommand );
+    void ( *Wait ) ( struct TTFT_Device* DeviceHandle );
+
+    /* Drives the reset line, low holds the display in reset */
+    void ( *SetReset ) ( struct TTFT_Device* DeviceHandle, bool Level );
+
+    /* Optional, exclusive use of a shared bus */
+    bool ( *Lock ) ( struct TTFT_Device* DeviceHandle );
+    void ( *Unlock ) ( struct TTFT_Device* DeviceHandle );
+};
+
+/* Pixels in the DMA buffer used for solid fills, single colour rows in updates and pixel writes in immediate mode */
+#define TTFT_FillBufferPixels 1024
+
+/* Set in TTFT_Device.InitEvents once the display has been reset and initialized */
+#define TTFT_Event_Ready BIT( 0 )
+
+/* Enough rows to render a 64 pixel tall glyph with an outline and shadow */
+#define TTFT_MaxGlyphRows 67
+
+/*
+ * Simple bump allocator over a caller supplied buffer.
+ * Allocations are only released all at once by TTFT_ArenaReset.
+ */
+struct TTFT_Arena {
+    uint8_t* Base;
+    size_t Size;
+    size_t Used;
+};
+
+/*
+ * Histogram buckets for flush statistics.
+ * Bucket 0 counts zeros, bucket n counts values from 2^(n-1) up to 2^n - 1
+ * and the last bucket counts everything bigger than that.
+ */
+#define TTFT_StatsBuckets 24
+
+/*
+ * One measurement taken on every flush, the average is Total / TTFT_FlushStats.Flushes.
+ */
+struct TTFT_StatsValue {
+    int64_t Min;
+    int64_t Max;
+    int64_t Total;
+    uint32_t Histogram[ TTFT_StatsBuckets ];
+};
+
+/*
+ * What updates have cost since the device was initialized or TTFT_ResetStats was called.
+ * Every TTFT_Update, TTFT_UpdateDirty and TTFT_UpdateRect is one flush.
+ */
+struct TTFT_FlushStats {
+    uint32_t Flushes;
+
+    /* Line or fill buffers that couldn't be allocated, whatever needed them was skipped */
+    uint32_t AllocFailures;
+
+    /* Bytes and transactions sent, including the address window commands */
+    struct TTFT_StatsValue Bytes;
+    struct TTFT_StatsValue Transactions;
+
+    /* Microseconds spent converting and queueing, and waiting on the transport or bus lock */
+    struct TTFT_StatsValue ConvertTime;
+    struct TTFT_StatsValue WaitTime;
+
+    /* Pixels in the rectangle sent */
+    struct TTFT_StatsValue Area;
+};
 
 struct TTFT_Device {
     int BacklightPin;
@@ -123,13 +288,82 @@ struct TTFT_Device {
     int Width;
     int Height;
 
-    spi_device_handle_t Handle;
+    /* How the display is reached and the transport's own state */
+    const struct TTFT_TransportOps* Ops;
+    void* TransportState;
+
+    void ( *ResetProc ) ( struct TTFT_Device* );
+    EventGroupHandle_t InitEvents;
+    volatile bool IsReady;
+    bool IsResumed;
 
     uint8_t* FrameBuffer;
     Color_t Palette[ 256 ];
 
+    /* Immediate mode has no framebuffer, every device has a small DMA buffer of TTFT_FillBufferPixels for solid runs */
+    bool IsImmediate;
+    uint8_t* FillBuffer;
+
+    /* Palette converted to (WirePaletteFormat), rebuilt on update if that isn't (PixelFormat) anymore */
+    TTFT_PixelFormat PixelFormat;
+    TTFT_PixelFormat WirePaletteFormat;
+    uint32_t WirePalette[ 256 ];
+
     int ( *FontGetGlyphWidth ) ( const struct TTFT_FontDef*, char );
     const struct TTFT_FontDef* Font;
+    int FontScale;
+    int FontStyle;
+    uint8_t FontOutlineColor;
+    uint8_t FontShadowColor;
+
+    /* Scratch space for drawing a glyph a row at a time, one bit per column */
+    uint64_t GlyphRows[ TTFT_MaxGlyphRows ];
+
+    /* Last MADCTL value sent with TTFT_SendCommand or an init table */
+    uint8_t AddressMode;
+
+    /* Framebuffer area driven by the display in partial mode, the whole screen otherwise */
+    int PartialX0;
+    int PartialY0;
+    int PartialX1;
+    int PartialY1;
+    bool IsPartial;
+    bool IsIdle;
+
+    /* Bounding box of everything drawn since the last update, empty when DirtyX0 > DirtyX1 */
+    int DirtyX0;
+    int DirtyY0;
+    int DirtyX1;
+    int DirtyY1;
+
+    /* SPI bus lock, taken when BusLockDepth goes above 0 and released when it gets back to 0 */
+    int BusLockDepth;
+    bool ShareBus;
+
+    /* Times the bus was acquired and microseconds spent acquiring it since the lock was last taken */
+    int BusLockCount;
+    int64_t BusLockTime;
+
+    /* Transport mode used by TTFT_SPIWrite and the transfers still queued by updates */
+    TTFT_Transport Transport;
+    size_t PollingThreshold;
+    int QueuedCount;
+
+    /* Totals for the flush in progress, added to (Stats) when it's done */
+    size_t FlushBytes;
+    int FlushTransactions;
+    int64_t FlushWaitTime;
+    struct TTFT_FlushStats Stats;
+
+    /*
+     * Transfer trace, see ttft_trace.h. NULL when not tracing.
+     * (TraceHead) counts every entry written and (TraceDone) every entry completed,
+     * the entry for a count is at (count % TraceSize).
+     */
+    struct TTFT_TraceEntry* Trace;
+    uint32_t TraceSize;
+    volatile uint32_t TraceHead;
+    volatile uint32_t TraceDone;
 };
 
 /*
@@ -155,6 +389,59 @@ bool SPIMasterInit( int MOSIPin, int MISOPin, int SCLKPin );
  */
 bool TTFT_Init( struct TTFT_Device* DeviceHandle, int Width, int Height, int CSPin, int DCPin, int ResetPin, int BacklightPin, void ( *ResetProc ) ( struct TTFT_Device* ), int SPIFrequency );
 
+/*
+ * TTFT_InitEx:
+ * Same as TTFT_Init with extra TTFT_InitFlags.
+ * 
+ * With TTFT_InitFlag_Async the display is reset in a background task while the caller carries on,
+ * drawing into the framebuffer is fine right away and updates wait for the display to be ready.
+ */
+bool TTFT_InitEx( struct TTFT_Device* DeviceHandle, int Width, int Height, int CSPin, int DCPin, int ResetPin, int BacklightPin, void ( *ResetProc ) ( struct TTFT_Device* ), int SPIFrequency, int Flags );
+
+/*
+ * TTFT_InitTransport:
+ * Same as TTFT_InitEx for a display reached through (Ops), which gets (Param) when opened.
+ * TTFT_Init and TTFT_InitEx use this with TTFT_ESP32SPI.
+ */
+bool TTFT_InitTransport( struct TTFT_Device* DeviceHandle, int Width, int Height, int BacklightPin, const struct TTFT_TransportOps* Ops, void* Param, void ( *ResetProc ) ( struct TTFT_Device* ), int Flags );
+
+/*
+ * TTFT_IsReady:
+ * Returns true once the display has finished resetting.
+ */
+bool TTFT_IsReady( struct TTFT_Device* DeviceHandle );
+
+/*
+ * TTFT_WaitReady:
+ * Waits up to (Timeout) ticks for the display to finish resetting.
+ * Returns true if the display is ready.
+ */
+bool TTFT_WaitReady( struct TTFT_Device* DeviceHandle, TickType_t Timeout );
+
+/*
+ * TTFT_Sleep:
+ * Turns the display off and puts the controller to sleep, GRAM and all settings are kept.
+ * Call before entering deep sleep so TTFT_InitFlag_Resume can skip the full init on wake.
+ * 
+ * Note:
+ * The reset pin is held high through deep sleep and the display must stay powered.
+ */
+void TTFT_Sleep( struct TTFT_Device* DeviceHandle );
+
+/*
+ * TTFT_Wake:
+ * Takes the controller out of sleep and turns the display back on.
+ * The display shows whatever was in GRAM before TTFT_Sleep.
+ */
+void TTFT_Wake( struct TTFT_Device* DeviceHandle );
+
+/*
+ * TTFT_IsResumed:
+ * Returns true if TTFT_InitEx resumed a sleeping display rather than resetting it.
+ * The framebuffer does not survive deep sleep but the display still shows the last frame.
+ */
+bool TTFT_IsResumed( struct TTFT_Device* DeviceHandle );
+
 /*
  * TTFT_DeInit:
  * Frees memory used by the shadow framebuffer and zeroes out the device handle.
@@ -168,9 +455,17 @@ void TTFT_DeInit( struct TTFT_Device* DeviceHandle );
  */
 void TTFT_SetBacklight( struct TTFT_Device* DeviceHandle, bool On );
 
+/*
+ * TTFT_RunInitTable:
+ * Sends every command in (Table) to the display.
+ * Commands are queued back to back and only waited on when a delay is needed,
+ * the queue is full or the end of the table is reached.
+ */
+void TTFT_RunInitTable( struct TTFT_Device* DeviceHandle, const uint8_t* Table );
+
 /*
  * TTFT_Reset_ILI9341:
- * Reset and init sequency for the ST7735 display controller.
+ * Reset and init sequence for the ILI9341 display controller.
  */
 void TTFT_Reset_ILI9341( struct TTFT_Device* DeviceHandle );
 
@@ -180,9 +475,109 @@ void TTFT_Reset_ILI9341( struct TTFT_Device* DeviceHandle );
  */
 void TTFT_Reset_ST7735( struct TTFT_Device* DeviceHandle );
 
+/*
+ * TTFT_Reset_ST7789:
+ * Reset and init sequence for the ST7789 display controller.
+ */
+void TTFT_Reset_ST7789( struct TTFT_Device* DeviceHandle );
+
+/*
+ * TTFT_Reset_ILI9488:
+ * Reset and init sequence for the ILI9488 display controller.
+ * Switches the device to 18 bit colour.
+ */
+void TTFT_Reset_ILI9488( struct TTFT_Device* DeviceHandle );
+
+/*
+ * TTFT_Reset_ILI9486:
+ * Reset and init sequence for the ILI9486 display controller.
+ */
+void TTFT_Reset_ILI9486( struct TTFT_Device* DeviceHandle );
+
+/*
+ * TTFT_AcquireBus:
+ * Takes the SPI bus for this display until the matching TTFT_ReleaseBus so each transaction
+ * doesn't have to, calls can be nested. Updates and direct panel writes do this themselves,
+ * wrapping a whole frame of immediate mode drawing saves taking it for every primitive.
+ */
+void TTFT_AcquireBus( struct TTFT_Device* DeviceHandle );
+
+/*
+ * TTFT_ReleaseBus:
+ * Releases the SPI bus once every TTFT_AcquireBus has been matched.
+ */
+void TTFT_ReleaseBus( struct TTFT_Device* DeviceHandle );
+
+/*
+ * TTFT_SetBusSharing:
+ * When on the bus is released and taken again between chunks of an update so other devices
+ * on the bus don't have to wait for the whole frame. Off by default.
+ */
+void TTFT_SetBusSharing( struct TTFT_Device* DeviceHandle, bool On );
+
+/*
+ * TTFT_GetBusLockStats:
+ * Returns how many times the bus was acquired and how long that took in microseconds,
+ * counted from the last time TTFT_AcquireBus took the lock (ie. the last update).
+ * Either pointer can be NULL.
+ */
+void TTFT_GetBusLockStats( struct TTFT_Device* DeviceHandle, int* OutCount, int64_t* OutMicroseconds );
+
+/*
+ * TTFT_GetStats:
+ * Copies the flush statistics of (DeviceHandle) into (OutStats).
+ */
+void TTFT_GetStats( struct TTFT_Device* DeviceHandle, struct TTFT_FlushStats* OutStats );
+
+/*
+ * TTFT_ResetStats:
+ * Starts the flush statistics over from nothing.
+ */
+void TTFT_ResetStats( struct TTFT_Device* DeviceHandle );
+
+/*
+ * TTFT_SetTransport:
+ * Picks how data is sent, transfers up to (PollingThreshold) bytes are polled in TTFT_Transport_Auto.
+ * Defaults to TTFT_Transport_Auto and TTFT_DefaultPollingThreshold.
+ */
+void TTFT_SetTransport( struct TTFT_Device* DeviceHandle, TTFT_Transport Transport, size_t PollingThreshold );
+
+/*
+ * TTFT_SetPartialArea:
+ * Only drives rows (y0) to (y1) of the display, the rest show the controller's non display colour.
+ * Updates are clipped to those rows so nothing outside is sent over SPI.
+ * 
+ * Note:
+ * Rows are in the display's native orientation, MADCTL rotation does not move them.
+ * They are converted to the framebuffer using the address mode at the time of the call,
+ * with MADCTL_MV set they are framebuffer columns. Send MADCTL first.
+ */
+void TTFT_SetPartialArea( struct TTFT_Device* DeviceHandle, int y0, int y1 );
+
+/*
+ * TTFT_ClearPartialArea:
+ * Goes back to driving the whole display.
+ * Everything is marked dirty since rows outside the partial area were not being sent.
+ */
+void TTFT_ClearPartialArea( struct TTFT_Device* DeviceHandle );
+
+/*
+ * TTFT_SetIdleMode:
+ * In idle mode the display only shows 8 colours (the top bit of each channel) at a reduced frame rate.
+ * Saves power on screens that rarely change.
+ */
+void TTFT_SetIdleMode( struct TTFT_Device* DeviceHandle, bool On );
+
+/*
+ * TTFT_SetPixelFormat:
+ * Changes the pixel format sent to the display.
+ */
+void TTFT_SetPixelFormat( struct TTFT_Device* DeviceHandle, TTFT_PixelFormat Format );
+
 /*
  * TTFT_SetPalette:
  * Sets the given alette as the new palette used to convert from indexed colour during updates.
+ * (NewPaletteSize) is in bytes.
  */
 void TTFT_SetPalette( struct TTFT_Device* DeviceHandle, const Color_t* NewPalette, size_t NewPaletteSize );
 
@@ -234,9 +629,35 @@ void IRAM_ATTR TTFT_FillRect( struct TTFT_Device* DeviceHandle, int x0, int y0,
  */
 void IRAM_ATTR TTFT_DrawBox( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1, int Thickness, uint8_t Color );
 
+/*
+ * TTFT_DrawBitmap:
+ * Copies a (Width) x (Height) block of colour indices to (x,y), clipped to the screen.
+ * Index 255 is copied like any other.
+ */
+void IRAM_ATTR TTFT_DrawBitmap( struct TTFT_Device* DeviceHandle, int x, int y, int Width, int Height, const uint8_t* Pixels );
+
+/*
+ * TTFT_PanelFillRect:
+ * Fills a rectangle directly in display memory by sending the fill buffer over and over.
+ * Used by immediate mode but works on any device, the framebuffer is not touched.
+ */
+void IRAM_ATTR TTFT_PanelFillRect( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1, uint8_t Color );
+
+/*
+ * TTFT_PanelSetWindow:
+ * Starts a write of the given rectangle directly to display memory, fill it with TTFT_PanelWritePixels.
+ */
+void IRAM_ATTR TTFT_PanelSetWindow( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1 );
+
+/*
+ * TTFT_PanelWritePixels:
+ * Converts (Count) colour indices and sends them to the window set by TTFT_PanelSetWindow.
+ */
+void IRAM_ATTR TTFT_PanelWritePixels( struct TTFT_Device* DeviceHandle, const uint8_t* Pixels, int Count );
+
 /*
  * TTFT_Update:
- * Converts the 8bit indexed shadow framebuffer to RGB565 (LineUpdateCount)
+ * Converts the 8bit indexed shadow framebuffer to RGB565 or RGB666 (LineUpdateCount)
  * lines at a time and sends it out over the SPI bus.
  * 
  * Note:
@@ -244,8 +665,59 @@ void IRAM_ATTR TTFT_DrawBox( struct TTFT_Device* DeviceHandle, int x0, int y0, i
  */
 void IRAM_ATTR TTFT_Update( struct TTFT_Device* DeviceHandle );
 
+/*
+ * TTFT_UpdateRect:
+ * Same as TTFT_Update but only sends the given rectangle of the framebuffer.
+ * Does not change the dirty rectangle unless sending fails, then the rectangle is marked dirty again
+ * so the next TTFT_UpdateDirty retries it. In partial mode only rows inside the partial area are sent.
+ */
+void IRAM_ATTR TTFT_UpdateRect( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1 );
+
+/*
+ * TTFT_UpdateDirty:
+ * Sends only the area drawn to since the last update, if any.
+ */
+void IRAM_ATTR TTFT_UpdateDirty( struct TTFT_Device* DeviceHandle );
+
+/*
+ * TTFT_MarkDirty:
+ * Adds the given rectangle to the area sent by the next TTFT_UpdateDirty.
+ * Drawing functions do this themselves, this is only needed when writing to the framebuffer directly.
+ * Coordinates are clipped to the screen.
+ */
+void IRAM_ATTR TTFT_MarkDirty( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1 );
+
+/*
+ * TTFT_ClearDirty:
+ * Forgets about anything drawn since the last update.
+ */
+void TTFT_ClearDirty( struct TTFT_Device* DeviceHandle );
+
+/*
+ * TTFT_SPIWrite:
+ * Sends (DataLength) bytes as a command or data and waits for them to go out, see TTFT_SetTransport.
+ */
 void TTFT_SPIWrite( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t DataLength, bool IsCommand );
 
+/*
+ * TTFT_ArenaInit:
+ * Sets up an arena to hand out memory from the given buffer.
+ */
+void TTFT_ArenaInit( struct TTFT_Arena* Arena, void* Buffer, size_t Size );
+
+/*
+ * TTFT_ArenaAlloc:
+ * Returns (Size) bytes from the arena aligned to 4 bytes, or NULL if the arena is full.
+ */
+void* TTFT_ArenaAlloc( struct TTFT_Arena* Arena, size_t Size );
+
+/*
+ * TTFT_ArenaReset:
+ * Releases every allocation made from the arena.
+ * Anything still pointing into it (labels, etc...) must be invalidated by the caller.
+ */
+void TTFT_ArenaReset( struct TTFT_Arena* Arena );
+
 #if 0
 static __attribute__( ( always_inline ) ) bool IsPixelVisible( struct ILI9341_Device* DeviceHandle, int x, int y ) {
     return x >= 0 && y >= 0 && x < DeviceHandle->Width && y < DeviceHandle->Height;
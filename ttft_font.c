@@ -13,11 +13,11 @@
 #include <math.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "driver/spi_master.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "ttft.h"
 #include "ttft_font.h"
+#include "ttft_profile.h"
 
 static bool IsCharacterInFont( const struct TTFT_FontDef* Font, char C ) {
     NullCheck( Font, return false );
@@ -55,10 +55,100 @@ static int GetGlyphWidthFixed( const struct TTFT_FontDef* Font, char C ) {
     return Font->Width;
 }
 
+const uint8_t* TTFT_FontGetGlyphData( const struct TTFT_FontDef* Font, char C ) {
+    const uint8_t* GlyphData = NULL;
+
+    NullCheck( Font, return NULL );
+
+    if ( IsCharacterInFont( Font, C ) == false ) {
+        return NULL;
+    }
+
+    NullCheck( ( GlyphData = GetGlyphPtr( Font, C ) ), return NULL );
+
+    /* The first byte in the glyph data is the width of the character in pixels, skip over */
+    return GlyphData + 1;
+}
+
+int TTFT_FontGetGlyphWidth( const struct TTFT_FontDef* Font, char C ) {
+    NullCheck( Font, return 0 );
+
+    if ( IsCharacterInFont( Font, C ) == false ) {
+        return 0;
+    }
+
+    return ( Font->IsMonospace == true ) ? GetGlyphWidthFixed( Font, C ) : GetGlyphWidthProportional( Font, C );
+}
+
+int TTFT_FontMeasureStringWithFont( const struct TTFT_FontDef* Font, const char* String ) {
+    int LineWidth = 0;
+    int Width = 0;
+
+    NullCheck( Font, return 0 );
+    NullCheck( String, return 0 );
+
+    for ( ; *String != 0; String++ ) {
+        if ( *String == '\n' ) {
+            Width = ( LineWidth > Width ) ? LineWidth : Width;
+            LineWidth = 0;
+        }
+        else {
+            LineWidth+= TTFT_FontGetGlyphWidth( Font, *String );
+        }
+    }
+
+    return ( LineWidth > Width ) ? LineWidth : Width;
+}
+
+int TTFT_FontGetColumnBytes( const struct TTFT_FontDef* Font ) {
+    NullCheck( Font, return 0 );
+
+    return RoundUpFontHeight( Font->Height ) / 8;
+}
+
+/*
+ * GetStyleExtraWidth:
+ * Number of columns (Style) adds to every character cell.
+ */
+static int GetStyleExtraWidth( int Style ) {
+    return ( ( Style & FontStyle_Bold ) ? 1 : 0 ) +
+        ( ( Style & FontStyle_Outline ) ? 2 : 0 ) +
+        ( ( Style & FontStyle_Shadow ) ? 1 : 0 );
+}
+
+/*
+ * GetStyleExtraHeight:
+ * Number of rows (Style) adds to every character cell.
+ */
+static int GetStyleExtraHeight( int Style ) {
+    return ( ( Style & FontStyle_Outline ) ? 2 : 0 ) +
+        ( ( Style & FontStyle_Shadow ) ? 1 : 0 );
+}
+
+/*
+ * FontFitsRowMasks:
+ * Returns true if every character cell of (Font) drawn in (Style) fits the row masks
+ * that scaled, styled and immediate mode characters are drawn with.
+ */
+static bool FontFitsRowMasks( const struct TTFT_FontDef* Font, int Style ) {
+    if ( Font->Width + GetStyleExtraWidth( Style ) > 64 || Font->Height + GetStyleExtraHeight( Style ) > TTFT_MaxGlyphRows ) {
+        ESP_LOGE( __FUNCTION__, "%s is too big to scale, style or draw without a framebuffer", ( Font->FontName != NULL ) ? Font->FontName : "Font" );
+        return false;
+    }
+
+    return true;
+}
+
 void TTFT_SetFont( struct TTFT_Device* DeviceHandle, const struct TTFT_FontDef* Font ) {
     NullCheck( DeviceHandle, return );
     NullCheck( Font, return );
 
+    if ( DeviceHandle->FontScale > 1 || DeviceHandle->FontStyle != FontStyle_Normal || DeviceHandle->IsImmediate == true ) {
+        if ( FontFitsRowMasks( Font, DeviceHandle->FontStyle ) == false ) {
+            return;
+        }
+    }
+
     DeviceHandle->FontGetGlyphWidth = ( Font->IsMonospace == true ) ? GetGlyphWidthFixed : GetGlyphWidthProportional;
     DeviceHandle->Font = Font;
 }
@@ -77,77 +167,424 @@ void TTFT_SetFontFixed( struct TTFT_Device* DeviceHandle ) {
     DeviceHandle->FontGetGlyphWidth = GetGlyphWidthFixed;
 }
 
-void IRAM_ATTR TTFT_FontDrawChar( struct TTFT_Device* DeviceHandle, char C, int x, int y, uint8_t FGColor, uint8_t BGColor ) {
+void TTFT_SetFontScale( struct TTFT_Device* DeviceHandle, int Scale ) {
+    NullCheck( DeviceHandle, return );
+    CheckBounds( Scale, 1, 8, return );
+
+    if ( Scale > 1 && DeviceHandle->Font != NULL && FontFitsRowMasks( DeviceHandle->Font, DeviceHandle->FontStyle ) == false ) {
+        return;
+    }
+
+    DeviceHandle->FontScale = Scale;
+}
+
+void TTFT_SetFontStyle( struct TTFT_Device* DeviceHandle, int Style, uint8_t OutlineColor, uint8_t ShadowColor ) {
+    NullCheck( DeviceHandle, return );
+
+    if ( Style != FontStyle_Normal && DeviceHandle->Font != NULL && FontFitsRowMasks( DeviceHandle->Font, Style ) == false ) {
+        return;
+    }
+
+    DeviceHandle->FontStyle = Style;
+    DeviceHandle->FontOutlineColor = OutlineColor;
+    DeviceHandle->FontShadowColor = ShadowColor;
+}
+
+
+int IRAM_ATTR TTFT_FontGetCharWidth( struct TTFT_Device* DeviceHandle, char C ) {
+    if ( IsCharacterInFont( DeviceHandle->Font, C ) == false ) {
+        return 0;
+    }
+
+    return ( DeviceHandle->FontGetGlyphWidth( DeviceHandle->Font, C ) + GetStyleExtraWidth( DeviceHandle->FontStyle ) ) * DeviceHandle->FontScale;
+}
+
+int TTFT_FontGetHeight( struct TTFT_Device* DeviceHandle ) {
+    NullCheck( DeviceHandle, return 0 );
+    NullCheck( DeviceHandle->Font, return 0 );
+
+    return ( DeviceHandle->Font->Height + GetStyleExtraHeight( DeviceHandle->FontStyle ) ) * DeviceHandle->FontScale;
+}
+
+/*
+ * LoadGlyphRows:
+ * Transposes the column major glyph data into one bit mask per row in DeviceHandle->GlyphRows,
+ * bit (n) being column (n) of the character cell. Zero bytes are skipped and set bits
+ * are found with count trailing zeros since most of a glyph is empty.
+ * 
+ * The glyph is placed inside the cell to leave room for the current style and
+ * made bold if needed.
+ * 
+ * Returns false if the character is not in the font or the cell will not fit in a row mask.
+ */
+static bool IRAM_ATTR LoadGlyphRows( struct TTFT_Device* DeviceHandle, char C, int* OutCellWidth, int* OutCellHeight ) {
+    const struct TTFT_FontDef* Font = DeviceHandle->Font;
     const uint8_t* GlyphData = NULL;
-    int GlyphColumnLen = 0;
-    int CharStartX =  0;
-    int CharStartY = 0;
+    uint64_t* Rows = DeviceHandle->GlyphRows;
+    uint64_t ColumnBit = 0;
+    unsigned int Bits = 0;
+    int ColumnBytes = 0;
     int CharWidth = 0;
-    int CharHeight = 0;
-    int CharEndX = 0;
-    int CharEndY = 0;
     int OffsetX = 0;
     int OffsetY = 0;
-    int YByte = 0;
-    int YBit = 0;
+    int Col = 0;
+    int Byte = 0;
+    int Row = 0;
+
+    if ( ( GlyphData = TTFT_FontGetGlyphData( Font, C ) ) == NULL ) {
+        return false;
+    }
+
+    CharWidth = DeviceHandle->FontGetGlyphWidth( Font, C );
+
+    *OutCellWidth = CharWidth + GetStyleExtraWidth( DeviceHandle->FontStyle );
+    *OutCellHeight = Font->Height + GetStyleExtraHeight( DeviceHandle->FontStyle );
+
+    if ( *OutCellWidth > 64 || *OutCellHeight > TTFT_MaxGlyphRows ) {
+        return false;
+    }
+
+    OffsetX = OffsetY = ( DeviceHandle->FontStyle & FontStyle_Outline ) ? 1 : 0;
+    ColumnBytes = TTFT_FontGetColumnBytes( Font );
+    CharWidth = ( CharWidth > Font->Width ) ? Font->Width : CharWidth;
+
+    memset( Rows, 0, sizeof( uint64_t ) * ( *OutCellHeight ) );
+
+    for ( Col = 0; Col < CharWidth; Col++ ) {
+        ColumnBit = 1ULL << ( Col + OffsetX );
+
+        for ( Byte = 0; Byte < ColumnBytes; Byte++ ) {
+            for ( Bits = *GlyphData++; Bits != 0; Bits&= Bits - 1 ) {
+                Row = ( Byte * 8 ) + __builtin_ctz( Bits );
+
+                if ( Row < Font->Height ) {
+                    Rows[ Row + OffsetY ]|= ColumnBit;
+                }
+            }
+        }
+    }
+
+    if ( DeviceHandle->FontStyle & FontStyle_Bold ) {
+        /* Horizontal dilation, smear every row one pixel to the right */
+        for ( Row = OffsetY; Row < OffsetY + Font->Height; Row++ ) {
+            Rows[ Row ]|= Rows[ Row ] << 1;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * DilateRows:
+ * Grows the glyph by a pixel in every direction around row (Row).
+ */
+static inline uint64_t DilateRows( const uint64_t* Rows, int Row, int CellHeight ) {
+    uint64_t Mask = Rows[ Row ];
+
+    Mask|= ( Row > 0 ) ? Rows[ Row - 1 ] : 0;
+    Mask|= ( Row + 1 < CellHeight ) ? Rows[ Row + 1 ] : 0;
+
+    return Mask | ( Mask << 1 ) | ( Mask >> 1 );
+}
+
+/*
+ * GetCellRowMasks:
+ * Works out which pixels of row (Row) in a loaded cell are outline and shadow for the current style.
+ */
+static inline void GetCellRowMasks( struct TTFT_Device* DeviceHandle, int Row, int CellHeight, uint64_t* OutOutline, uint64_t* OutShadow ) {
+    const uint64_t* Rows = DeviceHandle->GlyphRows;
+    uint64_t Shape = Rows[ Row ];
+    uint64_t Above = 0;
+
+    *OutOutline = *OutShadow = 0;
+
+    if ( DeviceHandle->FontStyle & FontStyle_Outline ) {
+        Shape = DilateRows( Rows, Row, CellHeight );
+        *OutOutline = Shape & ~Rows[ Row ];
+    }
+
+    if ( DeviceHandle->FontStyle & FontStyle_Shadow ) {
+        /* The shadow is the whole styled shape one pixel down and to the right */
+        Above = ( Row == 0 ) ? 0 : ( DeviceHandle->FontStyle & FontStyle_Outline ) ? DilateRows( Rows, Row - 1, CellHeight ) : Rows[ Row - 1 ];
+        *OutShadow = ( Above << 1 ) & ~Shape;
+    }
+}
+
+/*
+ * TTFT_FontStreamCellRows:
+ * Immediate mode version of TTFT_FontDrawCellRows for cells with no transparent pixels,
+ * the visible part of the cell is sent as a single window a scaled row at a time.
+ */
+static void IRAM_ATTR TTFT_FontStreamCellRows( struct TTFT_Device* DeviceHandle, int x, int y, int CellWidth, int CellHeight, uint8_t FGColor, uint8_t BGColor ) {
+    uint8_t Line[ 64 * 8 ];
+    uint64_t Outline = 0;
+    uint64_t Shadow = 0;
+    uint64_t Bit = 0;
+    int Scale = DeviceHandle->FontScale;
+    int X0 = ( x < 0 ) ? 0 : x;
+    int Y0 = ( y < 0 ) ? 0 : y;
+    int X1 = ( x + ( CellWidth * Scale ) > DeviceHandle->Width ) ? DeviceHandle->Width : x + ( CellWidth * Scale );
+    int Y1 = ( y + ( CellHeight * Scale ) > DeviceHandle->Height ) ? DeviceHandle->Height : y + ( CellHeight * Scale );
+    int RowY0 = 0;
+    int RowY1 = 0;
+    int Row = 0;
+    int Col = 0;
     int i = 0;
 
+    TTFT_AcquireBus( DeviceHandle );
+    TTFT_PanelSetWindow( DeviceHandle, X0, Y0, X1 - 1, Y1 - 1 );
+
+    for ( Row = 0; Row < CellHeight; Row++ ) {
+        RowY0 = y + ( Row * Scale );
+        RowY1 = RowY0 + Scale;
+
+        RowY0 = ( RowY0 < Y0 ) ? Y0 : RowY0;
+        RowY1 = ( RowY1 > Y1 ) ? Y1 : RowY1;
+
+        if ( RowY0 >= RowY1 ) {
+            continue;
+        }
+
+        GetCellRowMasks( DeviceHandle, Row, CellHeight, &Outline, &Shadow );
+
+        for ( Col = 0; Col < CellWidth; Col++ ) {
+            Bit = 1ULL << Col;
+
+            memset( &Line[ Col * Scale ],
+                ( DeviceHandle->GlyphRows[ Row ] & Bit ) ? FGColor :
+                ( Outline & Bit ) ? DeviceHandle->FontOutlineColor :
+                ( Shadow & Bit ) ? DeviceHandle->FontShadowColor :
+                BGColor,
+                Scale
+            );
+        }
+
+        for ( i = RowY0; i < RowY1; i++ ) {
+            TTFT_PanelWritePixels( DeviceHandle, &Line[ X0 - x ], X1 - X0 );
+        }
+    }
+
+    TTFT_ReleaseBus( DeviceHandle );
+}
+
+/*
+ * TTFT_FontDrawCellRows:
+ * Writes a character cell loaded by LoadGlyphRows to the framebuffer.
+ * The outline and drop shadow masks are computed from the neighbouring rows with
+ * shifts and ORs as each row is written, so every pixel is only written once.
+ * Runs of the same colour are written as memset spans (Scale) pixels tall.
+ */
+static void IRAM_ATTR TTFT_FontDrawCellRows( struct TTFT_Device* DeviceHandle, int x, int y, int CellWidth, int CellHeight, uint8_t FGColor, uint8_t BGColor ) {
+    const uint64_t* Rows = DeviceHandle->GlyphRows;
+    uint64_t Outline = 0;
+    uint64_t Shadow = 0;
+    uint64_t Bit = 0;
+    uint8_t RunColor = 0;
+    uint8_t Color = 0;
+    int Scale = DeviceHandle->FontScale;
+    int RunStart = 0;
+    int SpanX0 = 0;
+    int SpanX1 = 0;
+    int RowY0 = 0;
+    int RowY1 = 0;
+    int Row = 0;
+    int Col = 0;
+    int i = 0;
+
+    /* Entirely offscreen? */
+    if ( x >= DeviceHandle->Width || y >= DeviceHandle->Height || x + ( CellWidth * Scale ) <= 0 || y + ( CellHeight * Scale ) <= 0 ) {
+        return;
+    }
+
+    TTFT_MarkDirty( DeviceHandle, x, y, x + ( CellWidth * Scale ) - 1, y + ( CellHeight * Scale ) - 1 );
+
+    if ( DeviceHandle->IsImmediate == true && FGColor != 255 && BGColor != 255 &&
+        ( ( DeviceHandle->FontStyle & FontStyle_Outline ) == 0 || DeviceHandle->FontOutlineColor != 255 ) &&
+        ( ( DeviceHandle->FontStyle & FontStyle_Shadow ) == 0 || DeviceHandle->FontShadowColor != 255 ) ) {
+        TTFT_FontStreamCellRows( DeviceHandle, x, y, CellWidth, CellHeight, FGColor, BGColor );
+        return;
+    }
+
+    for ( Row = 0; Row < CellHeight; Row++ ) {
+        RowY0 = y + ( Row * Scale );
+        RowY1 = RowY0 + Scale;
+
+        RowY0 = ( RowY0 < 0 ) ? 0 : RowY0;
+        RowY1 = ( RowY1 > DeviceHandle->Height ) ? DeviceHandle->Height : RowY1;
+
+        if ( RowY0 >= RowY1 ) {
+            continue;
+        }
+
+        GetCellRowMasks( DeviceHandle, Row, CellHeight, &Outline, &Shadow );
+
+        /* Walk one past the end so the last run gets flushed */
+        for ( Col = 0, RunStart = 0; Col <= CellWidth; Col++ ) {
+            if ( Col < CellWidth ) {
+                Bit = 1ULL << Col;
+
+                Color = ( Rows[ Row ] & Bit ) ? FGColor :
+                    ( Outline & Bit ) ? DeviceHandle->FontOutlineColor :
+                    ( Shadow & Bit ) ? DeviceHandle->FontShadowColor :
+                    BGColor;
+
+                if ( Col == 0 ) {
+                    RunColor = Color;
+                }
+
+                if ( Color == RunColor ) {
+                    continue;
+                }
+            }
+
+            if ( RunColor != 255 ) {
+                SpanX0 = x + ( RunStart * Scale );
+                SpanX1 = x + ( Col * Scale );
+
+                SpanX0 = ( SpanX0 < 0 ) ? 0 : SpanX0;
+                SpanX1 = ( SpanX1 > DeviceHandle->Width ) ? DeviceHandle->Width : SpanX1;
+
+                if ( DeviceHandle->IsImmediate == true && SpanX0 < SpanX1 ) {
+                    TTFT_PanelFillRect( DeviceHandle, SpanX0, RowY0, SpanX1 - 1, RowY1 - 1, RunColor );
+                }
+
+                for ( i = RowY0; i < RowY1 && SpanX0 < SpanX1 && DeviceHandle->IsImmediate == false; i++ ) {
+                    memset( &DeviceHandle->FrameBuffer[ ( i * DeviceHandle->Width ) + SpanX0 ], RunColor, SpanX1 - SpanX0 );
+                }
+            }
+
+            RunStart = Col;
+            RunColor = Color;
+        }
+    }
+}
+
+/*
+ * TTFT_FontScatterGlyph:
+ * Writes only the set pixels of columns (Col0) to (Col1) and rows (Row0) to (Row1) of a glyph,
+ * or only the clear ones if (Invert) is true.
+ * Columns up to 64 pixels tall are loaded as a single word, clipped with a mask and walked
+ * with count trailing zeros so empty columns and rows cost nothing.
+ * Taller columns fall back to doing the same a byte at a time, skipping zero bytes.
+ */
+static void IRAM_ATTR TTFT_FontScatterGlyph( struct TTFT_Device* DeviceHandle, const uint8_t* GlyphData, int x, int y, int Col0, int Col1, int Row0, int Row1, uint8_t Color, bool Invert ) {
+    uint8_t InvertByte = ( Invert == true ) ? 0xFF : 0x00;
+    uint64_t InvertWord = ( Invert == true ) ? ~0ULL : 0;
+    int ColumnBytes = TTFT_FontGetColumnBytes( DeviceHandle->Font );
+    int Stride = DeviceHandle->Width;
+    uint8_t* Dest = NULL;
+    uint64_t RowMask = 0;
+    uint64_t Word = 0;
+    unsigned int Bits = 0;
+    int Byte = 0;
+    int Row = 0;
+    int Col = 0;
+
+    GlyphData+= ( Col0 * ColumnBytes );
+
+    if ( ColumnBytes <= 8 ) {
+        RowMask = ( ( Row1 >= 64 ) ? ~0ULL : ( ( 1ULL << Row1 ) - 1 ) ) & ~( ( 1ULL << Row0 ) - 1 );
+
+        for ( Col = Col0; Col < Col1; Col++, GlyphData+= ColumnBytes ) {
+            for ( Word = 0, Byte = 0; Byte < ColumnBytes; Byte++ ) {
+                Word|= ( ( uint64_t ) GlyphData[ Byte ] ) << ( Byte * 8 );
+            }
+
+            Dest = &DeviceHandle->FrameBuffer[ x + Col ];
+
+            for ( Word = ( Word ^ InvertWord ) & RowMask; Word != 0; Word&= Word - 1 ) {
+                Dest[ ( y + __builtin_ctzll( Word ) ) * Stride ] = Color;
+            }
+        }
+    }
+    else {
+        for ( Col = Col0; Col < Col1; Col++, GlyphData+= ColumnBytes ) {
+            for ( Byte = 0; Byte < ColumnBytes; Byte++ ) {
+                for ( Bits = GlyphData[ Byte ] ^ InvertByte; Bits != 0; Bits&= Bits - 1 ) {
+                    Row = ( Byte * 8 ) + __builtin_ctz( Bits );
+
+                    if ( Row >= Row0 && Row < Row1 ) {
+                        DeviceHandle->FrameBuffer[ ( ( y + Row ) * Stride ) + x + Col ] = Color;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void IRAM_ATTR TTFT_FontDrawChar( struct TTFT_Device* DeviceHandle, char C, int x, int y, uint8_t FGColor, uint8_t BGColor ) {
+    const uint8_t* GlyphData = NULL;
+    int CharWidth = 0;
+    int CharHeight = 0;
+    int Col0 = 0;
+    int Col1 = 0;
+    int Row0 = 0;
+    int Row1 = 0;
+    int DataCol1 = 0;
+    int i = 0;
+
+    TTFT_Profile( TTFT_Profile_FontDrawChar );
+
     NullCheck( DeviceHandle, return );
     NullCheck( DeviceHandle->Font, return );
-    
-    if ( IsCharacterInFont( DeviceHandle->Font, C ) == true ) {
-        NullCheck( ( GlyphData = GetGlyphPtr( DeviceHandle->Font, C ) ), return );
-
-        /* The first byte in the glyph data is the width of the character in pixels, skip over */
-        GlyphData++;
-        GlyphColumnLen = RoundUpFontHeight( DeviceHandle->Font->Height ) / 8;
-        
-        CharWidth = DeviceHandle->FontGetGlyphWidth( DeviceHandle->Font, C );
-        CharHeight = DeviceHandle->Font->Height;
-
-        CharStartX = x;
-        CharStartY = y;
-        
-        CharEndX = CharStartX + CharWidth;
-        CharEndY = CharStartY + CharHeight;
-
-        /* If the character is partially offscreen offset the end by
-        * distance between (coord) and 0.
-        */
-        OffsetX = ( CharStartX < 0 ) ? abs( CharStartX ) : 0;
-        OffsetY = ( CharStartY < 0 ) ? abs( CharStartY ) : 0;
-
-        /* This skips into the proper column within the glyph data */
-        GlyphData+= ( OffsetX * GlyphColumnLen );
-
-        CharStartX+= OffsetX;
-        CharStartY+= OffsetY;
-
-        /* Do not attempt to draw if this character is entirely offscreen */
-        if ( CharEndX < 0 || CharStartX >= DeviceHandle->Width || CharEndY < 0 || CharStartY >= DeviceHandle->Height ) {
-            //ClipDebug( x, y );
+
+    /* Scaled and styled characters go through the row mask path, if they fit */
+    if ( DeviceHandle->FontScale > 1 || DeviceHandle->FontStyle != FontStyle_Normal || DeviceHandle->IsImmediate == true ) {
+        if ( LoadGlyphRows( DeviceHandle, C, &CharWidth, &CharHeight ) == true ) {
+            TTFT_ProfilePixels( CharWidth * CharHeight * DeviceHandle->FontScale * DeviceHandle->FontScale );
+            TTFT_FontDrawCellRows( DeviceHandle, x, y, CharWidth, CharHeight, FGColor, BGColor );
             return;
         }
+    }
 
-        /* Do not attempt to draw past the end of the screen */
-        CharEndX = ( CharEndX >= DeviceHandle->Width ) ? DeviceHandle->Width - 1 : CharEndX;
-        CharEndY = ( CharEndY >= DeviceHandle->Height ) ? DeviceHandle->Height - 1 : CharEndY;
+    /* Immediate mode only has the row mask path */
+    if ( DeviceHandle->IsImmediate == true ) {
+        return;
+    }
 
-        for ( x = CharStartX; x < CharEndX; x++ ) {
-            for ( y = CharStartY, i = 0; y < CharEndY && i < CharHeight; y++, i++ ) {
-                YByte = ( i + OffsetY ) / 8;
-                YBit = ( i + OffsetY ) & 0x07;
+    if ( ( GlyphData = TTFT_FontGetGlyphData( DeviceHandle->Font, C ) ) == NULL ) {
+        return;
+    }
 
-                if ( GlyphData[ YByte ] & BIT( YBit ) ) {
-                    TTFT_SetPixel( DeviceHandle, x, y, FGColor );
-                } else {
-                    TTFT_SetPixel( DeviceHandle, x, y, BGColor );
-                } 
-            }
+    CharWidth = DeviceHandle->FontGetGlyphWidth( DeviceHandle->Font, C );
+    CharHeight = DeviceHandle->Font->Height;
+
+    /* Clip the character cell to the screen */
+    Col0 = ( x < 0 ) ? -x : 0;
+    Row0 = ( y < 0 ) ? -y : 0;
+    Col1 = ( x + CharWidth > DeviceHandle->Width ) ? DeviceHandle->Width - x : CharWidth;
+    Row1 = ( y + CharHeight > DeviceHandle->Height ) ? DeviceHandle->Height - y : CharHeight;
+
+    /* Do not attempt to draw if this character is entirely offscreen */
+    if ( Col0 >= Col1 || Row0 >= Row1 ) {
+        return;
+    }
+
+    TTFT_ProfilePixels( ( Col1 - Col0 ) * ( Row1 - Row0 ) );
+    TTFT_MarkDirty( DeviceHandle, x + Col0, y + Row0, x + Col1 - 1, y + Row1 - 1 );
 
-            GlyphData+= GlyphColumnLen;
+    /* Fixed width mode may make the cell wider than the glyph data */
+    DataCol1 = ( Col1 > DeviceHandle->Font->Width ) ? DeviceHandle->Font->Width : Col1;
+
+    if ( FGColor == 255 && BGColor != 255 ) {
+        /* Transparent foreground, only the background shows */
+        if ( Col0 < DataCol1 ) {
+            TTFT_FontScatterGlyph( DeviceHandle, GlyphData, x, y, Col0, DataCol1, Row0, Row1, BGColor, true );
+        }
+
+        Col0 = ( DataCol1 > Col0 ) ? DataCol1 : Col0;
+    }
+
+    /* Opaque text fills whole rows of the cell first, transparent text never touches the background */
+    if ( BGColor != 255 && Col0 < Col1 ) {
+        for ( i = Row0; i < Row1; i++ ) {
+            memset( &DeviceHandle->FrameBuffer[ ( ( y + i ) * DeviceHandle->Width ) + x + Col0 ], BGColor, Col1 - Col0 );
         }
     }
+
+    if ( FGColor != 255 && Col0 < DataCol1 ) {
+        TTFT_FontScatterGlyph( DeviceHandle, GlyphData, x, y, Col0, DataCol1, Row0, Row1, FGColor, false );
+    }
 }
 
 int IRAM_ATTR TTFT_FontMeasureString( struct TTFT_Device* DeviceHandle, const char* String ) {
@@ -156,15 +593,12 @@ int IRAM_ATTR TTFT_FontMeasureString( struct TTFT_Device* DeviceHandle, const ch
     int i = 0;
 
     NullCheck( DeviceHandle, return 0 );
-    NullCheck( DeviceHandle->FrameBuffer, return 0 );
     NullCheck( DeviceHandle->Font, return 0 );
     NullCheck( String, return 0 );
 
     if ( ( StringLengthChars = strlen( String ) ) > 0 ) {
         for ( i = 0; i < StringLengthChars; i++ ) {
-            if ( IsCharacterInFont( DeviceHandle->Font, String[ i ] ) == true ) {
-                StringLengthPixels+= DeviceHandle->FontGetGlyphWidth( DeviceHandle->Font, String[ i ] );
-            }
+            StringLengthPixels+= TTFT_FontGetCharWidth( DeviceHandle, String[ i ] );
         }
     }
 
@@ -177,17 +611,20 @@ int IRAM_ATTR TTFT_FontDrawString( struct TTFT_Device* DeviceHandle, int x, int
     int SavedX = x;
     int i = 0;
 
+    TTFT_Profile( TTFT_Profile_FontDrawString );
+
     NullCheck( DeviceHandle, return 0 );
-    NullCheck( DeviceHandle->FrameBuffer, return 0 );
+    CheckDrawTarget( DeviceHandle, return 0 );
     NullCheck( DeviceHandle->Font, return 0 );
     NullCheck( Text, return 0 );
 
     if ( ( StringLengthPixels = TTFT_FontMeasureString( DeviceHandle, Text ) ) > 0 ) {
         StringLengthChars = strlen( Text );
+        TTFT_ProfilePixels( StringLengthPixels * TTFT_FontGetHeight( DeviceHandle ) );
 
         for ( i = 0; i < StringLengthChars; i++ ) {
             if ( Text[ i ] == '\n' ) {
-                y+= DeviceHandle->Font->Height;
+                y+= TTFT_FontGetHeight( DeviceHandle );
                 x = SavedX;
 
                 continue;
@@ -195,7 +632,7 @@ int IRAM_ATTR TTFT_FontDrawString( struct TTFT_Device* DeviceHandle, int x, int
 
             if ( IsCharacterInFont( DeviceHandle->Font, Text[ i ] ) == true ) {
                 TTFT_FontDrawChar( DeviceHandle, Text[ i ], x, y, FGColor, BGColor );
-                x+= DeviceHandle->FontGetGlyphWidth( DeviceHandle->Font, Text[ i ] );
+                x+= TTFT_FontGetCharWidth( DeviceHandle, Text[ i ] );
             }
         }
 
@@ -205,6 +642,272 @@ int IRAM_ATTR TTFT_FontDrawString( struct TTFT_Device* DeviceHandle, int x, int
     return 0;
 }
 
+/*
+ * TTFT_FontDrawColumnRotated:
+ * Draws one glyph column (Column) at distance (u) along a rotated line of text (Length) pixels long.
+ * Rows of the column that land offscreen are masked off before any pixels are written.
+ */
+static void IRAM_ATTR TTFT_FontDrawColumnRotated( struct TTFT_Device* DeviceHandle, uint64_t Column, int u, int Length, int x, int y, TextRotation Rotation, uint8_t FGColor, uint8_t BGColor ) {
+    int Height = DeviceHandle->Font->Height;
+    int Stride = DeviceHandle->Width;
+    uint64_t RowMask = 0;
+    uint8_t* Dest = NULL;
+    int V0 = 0;
+    int V1 = 0;
+    int v = 0;
+
+    switch ( Rotation ) {
+        case TextRotation_90: {
+            /* Column becomes the row (y + u), glyph row v lands at x + ( Height - 1 - v ) */
+            if ( y + u < 0 || y + u >= DeviceHandle->Height ) {
+                return;
+            }
+
+            V0 = ( x + Height > Stride ) ? ( x + Height ) - Stride : 0;
+            V1 = ( x < 0 ) ? Height + x : Height;
+            Dest = &DeviceHandle->FrameBuffer[ ( ( y + u ) * Stride ) + x + Height - 1 ];
+            break;
+        }
+        case TextRotation_270: {
+            /* Column becomes the row (y + Length - 1 - u), glyph row v lands at x + v */
+            if ( y + Length - 1 - u < 0 || y + Length - 1 - u >= DeviceHandle->Height ) {
+                return;
+            }
+
+            V0 = ( x < 0 ) ? -x : 0;
+            V1 = ( x + Height > Stride ) ? Stride - x : Height;
+            Dest = &DeviceHandle->FrameBuffer[ ( ( y + Length - 1 - u ) * Stride ) + x ];
+            break;
+        }
+        case TextRotation_180: {
+            /* Column becomes the screen column (x + Length - 1 - u), upside down */
+            if ( x + Length - 1 - u < 0 || x + Length - 1 - u >= Stride ) {
+                return;
+            }
+
+            V0 = ( y + Height > DeviceHandle->Height ) ? ( y + Height ) - DeviceHandle->Height : 0;
+            V1 = ( y < 0 ) ? Height + y : Height;
+            Dest = &DeviceHandle->FrameBuffer[ ( ( y + Height - 1 ) * Stride ) + x + Length - 1 - u ];
+            break;
+        }
+        default: {
+            /* Rejected by TTFT_FontDrawStringRotated */
+            return;
+        }
+    };
+
+    if ( V0 >= V1 || ( FGColor == 255 && BGColor == 255 ) ) {
+        return;
+    }
+
+    if ( FGColor == 255 ) {
+        /* Transparent foreground over an opaque background, only the unset pixels get drawn */
+        Column = ~Column;
+        FGColor = BGColor;
+    }
+    else if ( BGColor != 255 ) {
+        switch ( Rotation ) {
+            case TextRotation_90: memset( Dest - ( V1 - 1 ), BGColor, V1 - V0 ); break;
+            case TextRotation_270: memset( Dest + V0, BGColor, V1 - V0 ); break;
+            case TextRotation_180: {
+                for ( v = V0; v < V1; v++ ) {
+                    Dest[ -v * Stride ] = BGColor;
+                }
+
+                break;
+            }
+            default: break;
+        };
+    }
+
+    RowMask = ( ( V1 >= 64 ) ? ~0ULL : ( ( 1ULL << V1 ) - 1 ) ) & ~( ( 1ULL << V0 ) - 1 );
+
+    for ( Column&= RowMask; Column != 0; Column&= Column - 1 ) {
+        v = __builtin_ctzll( Column );
+
+        switch ( Rotation ) {
+            case TextRotation_90: Dest[ -v ] = FGColor; break;
+            case TextRotation_270: Dest[ v ] = FGColor; break;
+            case TextRotation_180: Dest[ -v * Stride ] = FGColor; break;
+            default: break;
+        };
+    }
+}
+
+int IRAM_ATTR TTFT_FontDrawStringRotated( struct TTFT_Device* DeviceHandle, int x, int y, TextRotation Rotation, uint8_t FGColor, uint8_t BGColor, const char* Text ) {
+    const struct TTFT_FontDef* Font = NULL;
+    const uint8_t* GlyphData = NULL;
+    uint64_t Column = 0;
+    int ColumnBytes = 0;
+    int CharWidth = 0;
+    int Length = 0;
+    int Byte = 0;
+    int Col = 0;
+    int u = 0;
+    int i = 0;
+
+    TTFT_Profile( TTFT_Profile_FontDrawStringRotated );
+
+    NullCheck( DeviceHandle, return 0 );
+    NullCheck( DeviceHandle->FrameBuffer, return 0 );
+    NullCheck( DeviceHandle->Font, return 0 );
+    NullCheck( Text, return 0 );
+
+    Font = DeviceHandle->Font;
+    ColumnBytes = TTFT_FontGetColumnBytes( Font );
+
+    CheckBounds( Font->Height, 1, 64, return 0 );
+
+    if ( Rotation != TextRotation_0 && Rotation != TextRotation_90 && Rotation != TextRotation_180 && Rotation != TextRotation_270 ) {
+        ESP_LOGE( __FUNCTION__, "Unsupported rotation %d", ( int ) Rotation );
+        return 0;
+    }
+
+    if ( Rotation == TextRotation_0 ) {
+        TTFT_FontDrawString( DeviceHandle, x, y, FGColor, BGColor, Text );
+        return TTFT_FontMeasureString( DeviceHandle, Text );
+    }
+
+    for ( i = 0; Text[ i ] != 0; i++ ) {
+        if ( IsCharacterInFont( Font, Text[ i ] ) == true ) {
+            Length+= DeviceHandle->FontGetGlyphWidth( Font, Text[ i ] );
+        }
+    }
+
+    TTFT_ProfilePixels( Length * Font->Height );
+
+    if ( Rotation == TextRotation_180 ) {
+        TTFT_MarkDirty( DeviceHandle, x, y, x + Length - 1, y + Font->Height - 1 );
+    }
+    else {
+        TTFT_MarkDirty( DeviceHandle, x, y, x + Font->Height - 1, y + Length - 1 );
+    }
+
+    for ( i = 0, u = 0; Text[ i ] != 0; i++ ) {
+        if ( ( GlyphData = TTFT_FontGetGlyphData( Font, Text[ i ] ) ) == NULL ) {
+            continue;
+        }
+
+        CharWidth = DeviceHandle->FontGetGlyphWidth( Font, Text[ i ] );
+
+        for ( Col = 0; Col < CharWidth; Col++, u++ ) {
+            Column = 0;
+
+            /* Fixed width mode may make the cell wider than the glyph data */
+            if ( Col < Font->Width ) {
+                for ( Byte = 0; Byte < ColumnBytes; Byte++ ) {
+                    Column|= ( ( uint64_t ) GlyphData[ ( Col * ColumnBytes ) + Byte ] ) << ( Byte * 8 );
+                }
+            }
+
+            TTFT_FontDrawColumnRotated( DeviceHandle, Column, u, Length, x, y, Rotation, FGColor, BGColor );
+        }
+    }
+
+    return Length;
+}
+
+int TTFT_FontFormatFixed( char* Buffer, int32_t Value, int Decimals, int MinWidth, int Flags ) {
+    char Digits[ TTFT_NumberMaxLength ];
+    uint32_t Magnitude = 0;
+    char Sign = 0;
+    int DigitCount = 0;
+    int Length = 0;
+    int Padding = 0;
+    int i = 0;
+
+    NullCheck( Buffer, return 0 );
+    CheckBounds( Decimals, 0, 9, Decimals = 0 );
+
+    /* Negate as unsigned so INT32_MIN survives */
+    Magnitude = ( Value < 0 ) ? ( 0u - ( uint32_t ) Value ) : ( uint32_t ) Value;
+
+    if ( Value < 0 ) {
+        Sign = '-';
+    }
+    else if ( Flags & NumberFormat_ForceSign ) {
+        Sign = '+';
+    }
+
+    /* Digits come out backwards, always at least one before the decimal point */
+    do {
+        if ( Decimals > 0 && DigitCount == Decimals ) {
+            Digits[ DigitCount++ ] = '.';
+        }
+
+        Digits[ DigitCount++ ] = '0' + ( Magnitude % 10 );
+        Magnitude/= 10;
+    } while ( Magnitude > 0 || DigitCount <= Decimals );
+
+    Length = DigitCount + ( ( Sign != 0 ) ? 1 : 0 );
+    MinWidth = ( MinWidth > TTFT_NumberMaxLength ) ? TTFT_NumberMaxLength : MinWidth;
+    Padding = ( MinWidth > Length ) ? MinWidth - Length : 0;
+
+    Length = 0;
+
+    if ( ( Flags & ( NumberFormat_AlignLeft | NumberFormat_ZeroPad ) ) == 0 ) {
+        for ( i = 0; i < Padding; i++ ) {
+            Buffer[ Length++ ] = ' ';
+        }
+    }
+
+    if ( Sign != 0 ) {
+        Buffer[ Length++ ] = Sign;
+    }
+
+    if ( ( Flags & NumberFormat_ZeroPad ) && ( Flags & NumberFormat_AlignLeft ) == 0 ) {
+        for ( i = 0; i < Padding; i++ ) {
+            Buffer[ Length++ ] = '0';
+        }
+    }
+
+    while ( DigitCount > 0 ) {
+        Buffer[ Length++ ] = Digits[ --DigitCount ];
+    }
+
+    if ( Flags & NumberFormat_AlignLeft ) {
+        for ( i = 0; i < Padding; i++ ) {
+            Buffer[ Length++ ] = ' ';
+        }
+    }
+
+    Buffer[ Length ] = 0;
+    return Length;
+}
+
+int IRAM_ATTR TTFT_FontDrawInt( struct TTFT_Device* DeviceHandle, int x, int y, uint8_t FGColor, uint8_t BGColor, int32_t Value, int MinWidth, int Flags ) {
+    return TTFT_FontDrawFixed( DeviceHandle, x, y, FGColor, BGColor, Value, 0, MinWidth, Flags );
+}
+
+int IRAM_ATTR TTFT_FontDrawFixed( struct TTFT_Device* DeviceHandle, int x, int y, uint8_t FGColor, uint8_t BGColor, int32_t Value, int Decimals, int MinWidth, int Flags ) {
+    char Text[ TTFT_NumberMaxLength + 1 ];
+    int Length = 0;
+    int CharWidth = 0;
+    int i = 0;
+
+    TTFT_Profile( TTFT_Profile_FontDrawFixed );
+
+    NullCheck( DeviceHandle, return 0 );
+    CheckDrawTarget( DeviceHandle, return 0 );
+    NullCheck( DeviceHandle->Font, return 0 );
+
+    Length = TTFT_FontFormatFixed( Text, Value, Decimals, MinWidth, Flags );
+
+    /* Skip TTFT_FontDrawString, we already know the length and there are no newlines */
+    for ( i = 0; i < Length; i++ ) {
+        if ( IsCharacterInFont( DeviceHandle->Font, Text[ i ] ) == true ) {
+            CharWidth = TTFT_FontGetCharWidth( DeviceHandle, Text[ i ] );
+
+            TTFT_FontDrawChar( DeviceHandle, Text[ i ], x, y, FGColor, BGColor );
+            TTFT_ProfilePixels( CharWidth * TTFT_FontGetHeight( DeviceHandle ) );
+
+            x+= CharWidth;
+        }
+    }
+
+    return x;
+}
+
 int TTFT_FontDrawAnchoredString( struct TTFT_Device* DeviceHandle, TextAnchor Anchor, const char* Text, uint8_t FGColor, uint8_t BGColor ) {
     int x = 0;
     int y = 0;
@@ -226,7 +929,7 @@ void TTFT_FontGetAnchoredStringCoords( struct TTFT_Device* DeviceHandle, int* Ou
     NullCheck( Text, return );
 
     StringWidth = TTFT_FontMeasureString( DeviceHandle, Text );
-    StringHeight = DeviceHandle->Font->Height;
+    StringHeight = TTFT_FontGetHeight( DeviceHandle );
 
     switch ( Anchor ) {
         case TextAnchor_East: {
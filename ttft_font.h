@@ -21,6 +21,42 @@ typedef enum {
     TextAnchor_Center
 } TextAnchor;
 
+/*
+ * Flags for TTFT_FontFormatFixed, TTFT_FontDrawInt and TTFT_FontDrawFixed.
+ * Numbers are right aligned and space padded unless told otherwise.
+ */
+typedef enum {
+    NumberFormat_Default = 0,
+    NumberFormat_ZeroPad = 1,
+    NumberFormat_ForceSign = 2,
+    NumberFormat_AlignLeft = 4
+} NumberFormat;
+
+/*
+ * Clockwise rotations for TTFT_FontDrawStringRotated.
+ */
+typedef enum {
+    TextRotation_0 = 0,
+    TextRotation_90 = 90,
+    TextRotation_180 = 180,
+    TextRotation_270 = 270
+} TextRotation;
+
+/*
+ * Synthetic styles for TTFT_SetFontStyle, these can be combined.
+ */
+typedef enum {
+    FontStyle_Normal = 0,
+    FontStyle_Bold = 1,
+    FontStyle_Outline = 2,
+    FontStyle_Shadow = 4
+} FontStyle;
+
+/*
+ * Longest string TTFT_FontFormatFixed will produce, not including the terminator.
+ */
+#define TTFT_NumberMaxLength 23
+
 struct TTFT_Device;
 
 struct TTFT_FontDef {
@@ -72,10 +108,167 @@ void TTFT_SetFontSolid( struct TTFT_Device* DeviceHandle );
 void TTFT_SetFontProportional( struct TTFT_Device* DeviceHandle );
 void TTFT_SetFontFixed( struct TTFT_Device* DeviceHandle );
 
+/*
+ * TTFT_SetFontScale:
+ * Draws every pixel of the current font as a (Scale)x(Scale) block, from 1 to 8.
+ * Lets a small font stand in for a large one without another font table in flash.
+ */
+void TTFT_SetFontScale( struct TTFT_Device* DeviceHandle, int Scale );
+
+/*
+ * TTFT_SetFontStyle:
+ * Sets the synthetic style used when drawing characters, a combination of FontStyle values.
+ * 
+ * Bold smears each glyph one pixel to the right, Outline surrounds it with a one pixel
+ * border of (OutlineColor) and Shadow adds a drop shadow of (ShadowColor) one pixel down and to the right.
+ * Character cells grow to fit the style so neighbouring characters never overlap.
+ * 
+ * Note:
+ * Styling and scaling work on fonts up to 60 pixels wide, styles that would not fit are refused.
+ * TTFT_SetFont and TTFT_SetFontScale refuse such fonts too while a style or scale is set,
+ * as does TTFT_SetFont on a device without a framebuffer.
+ */
+void TTFT_SetFontStyle( struct TTFT_Device* DeviceHandle, int Style, uint8_t OutlineColor, uint8_t ShadowColor );
+
+/*
+ * TTFT_FontGetCharWidth:
+ * Returns how far the pen moves after drawing (C) with the current font, style and scale,
+ * or 0 if the character is not in the font.
+ */
+int IRAM_ATTR TTFT_FontGetCharWidth( struct TTFT_Device* DeviceHandle, char C );
+
+/*
+ * TTFT_FontGetHeight:
+ * Returns the height of a line of text in the current font, style and scale.
+ */
+int TTFT_FontGetHeight( struct TTFT_Device* DeviceHandle );
+
 int IRAM_ATTR TTFT_FontMeasureString( struct TTFT_Device* DeviceHandle, const char* String );
 int IRAM_ATTR TTFT_FontDrawString( struct TTFT_Device* DeviceHandle, int x, int y, uint8_t FGColor, uint8_t BGColor, const char* String );
 void IRAM_ATTR TTFT_FontDrawChar( struct TTFT_Device* DeviceHandle, char C, int x, int y, uint8_t FGColor, uint8_t BGColor );
 
+/*
+ * TTFT_FontDrawStringRotated:
+ * Draws a single line of text rotated clockwise by (Rotation) with (x,y) being the top left
+ * corner of the rotated text. TextRotation_90 reads top to bottom, TextRotation_270 reads bottom
+ * to top as on the y axis of a chart.
+ * 
+ * Glyphs are stored a column at a time so at 90 and 270 degrees every glyph column
+ * is written as a single framebuffer row.
+ * 
+ * Note:
+ * Rotated text ignores the font scale and style, only works with fonts up to 64 pixels tall,
+ * does not handle newlines and needs a framebuffer.
+ * 
+ * Returns the length of the text in pixels, or 0 if (Rotation) isn't one of the TextRotation values.
+ */
+int IRAM_ATTR TTFT_FontDrawStringRotated( struct TTFT_Device* DeviceHandle, int x, int y, TextRotation Rotation, uint8_t FGColor, uint8_t BGColor, const char* Text );
+
+/*
+ * TTFT_FontGetGlyphData:
+ * Returns a pointer to the column data of the given character, skipping over the width byte.
+ * Each column is TTFT_FontGetColumnBytes( Font ) bytes long, least significant bit at the top.
+ * Returns NULL if the character is not in the font.
+ */
+const uint8_t* TTFT_FontGetGlyphData( const struct TTFT_FontDef* Font, char C );
+
+/*
+ * TTFT_FontGetColumnBytes:
+ * Number of bytes used to store a single glyph column.
+ */
+int TTFT_FontGetColumnBytes( const struct TTFT_FontDef* Font );
+
+/*
+ * TTFT_FontFormatFixed:
+ * Formats (Value) / 10^(Decimals) into (Buffer) without going through printf.
+ * (MinWidth) pads the result out to that many characters, (Flags) is a combination of NumberFormat values.
+ * (Buffer) should be at least TTFT_NumberMaxLength + 1 bytes.
+ * 
+ * Returns the length of the formatted string.
+ */
+int TTFT_FontFormatFixed( char* Buffer, int32_t Value, int Decimals, int MinWidth, int Flags );
+
+/*
+ * TTFT_FontDrawInt:
+ * Draws an integer with the current font, see TTFT_FontFormatFixed for (MinWidth) and (Flags).
+ * Returns the x coordinate just past the last character.
+ */
+int IRAM_ATTR TTFT_FontDrawInt( struct TTFT_Device* DeviceHandle, int x, int y, uint8_t FGColor, uint8_t BGColor, int32_t Value, int MinWidth, int Flags );
+
+/*
+ * TTFT_FontDrawFixed:
+ * Draws (Value) / 10^(Decimals) with the current font, see TTFT_FontFormatFixed for (MinWidth) and (Flags).
+ * ie. TTFT_FontDrawFixed( ..., 1234, 2, ... ) draws "12.34".
+ * Returns the x coordinate just past the last character.
+ */
+int IRAM_ATTR TTFT_FontDrawFixed( struct TTFT_Device* DeviceHandle, int x, int y, uint8_t FGColor, uint8_t BGColor, int32_t Value, int Decimals, int MinWidth, int Flags );
+
+/*
+ * TTFT_FontGetGlyphWidth:
+ * Width of (C) in its font's natural mode, fixed for monospace fonts and proportional otherwise.
+ * Returns 0 if the character is not in the font.
+ */
+int TTFT_FontGetGlyphWidth( const struct TTFT_FontDef* Font, char C );
+
+/*
+ * TTFT_FontMeasureStringWithFont:
+ * Measures (String) in (Font)'s natural mode without needing a device.
+ * Returns the width of the widest line in pixels.
+ */
+int TTFT_FontMeasureStringWithFont( const struct TTFT_FontDef* Font, const char* String );
+
+/*
+ * TTFT_FontGetCount:
+ * Number of fonts in the registry, compiled in fonts first followed by registered ones.
+ */
+int TTFT_FontGetCount( void );
+
+/*
+ * TTFT_FontGetByIndex:
+ * Returns the registered font at (Index), or NULL if out of range.
+ */
+const struct TTFT_FontDef* TTFT_FontGetByIndex( int Index );
+
+/*
+ * Number of fonts that can be added to the registry at runtime, ie. from font packs.
+ */
+#define TTFT_MaxRegisteredFonts 16
+
+/*
+ * TTFT_FontRegister:
+ * Adds a font to the registry so TTFT_FontFind and friends will consider it.
+ * (Font) must stay valid until it is unregistered.
+ */
+bool TTFT_FontRegister( const struct TTFT_FontDef* Font );
+
+/*
+ * TTFT_FontUnregister:
+ * Removes a font added by TTFT_FontRegister.
+ */
+void TTFT_FontUnregister( const struct TTFT_FontDef* Font );
+
+/*
+ * TTFT_FontIsFamily:
+ * Returns true if (Font) belongs to (Family), ie. "droid sans" matches "droid sans 19x25"
+ * but not "droid sans fallback 19x24". Case insensitive, a NULL family matches everything.
+ */
+bool TTFT_FontIsFamily( const struct TTFT_FontDef* Font, const char* Family );
+
+/*
+ * TTFT_FontFind:
+ * Returns the tallest font in (Family) that is no taller than (MaxHeight),
+ * or NULL if there isn't one.
+ */
+const struct TTFT_FontDef* TTFT_FontFind( const char* Family, int MaxHeight );
+
+/*
+ * TTFT_FontFindFit:
+ * Returns the tallest font in (Family) no taller than (MaxHeight) in which (Text)
+ * is no wider than (MaxWidth), or NULL if the text will not fit in any of them.
+ * Pass MaxHeight <= 0 to only constrain the width.
+ */
+const struct TTFT_FontDef* TTFT_FontFindFit( const char* Family, const char* Text, int MaxWidth, int MaxHeight );
+
 void TTFT_FontGetAnchoredStringCoords( struct TTFT_Device* DeviceHandle, int* OutX, int* OutY, TextAnchor Anchor, const char* Text );
 int TTFT_FontDrawAnchoredString( struct TTFT_Device* DeviceHandle, TextAnchor Anchor, const char* Text, uint8_t FGColor, uint8_t BGColor );
 
@@ -0,0 +1,191 @@
+/**
+ * Copyright (c) 2018 Tara Keeling
+ * 
+ * This software is released under the MIT License.
+ * https://opensource.org/licenses/MIT
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "ttft.h"
+#include "ttft_font.h"
+
+/*
+ * Every font compiled into the component.
+ * Font names are "<family> <width>x<height>", the family is everything before the size.
+ */
+static const struct TTFT_FontDef* const BuiltinFonts[ ] = {
+    &Font_Droid_Sans_Fallback_9x12,
+    &Font_Droid_Sans_Fallback_11x12,
+    &Font_Droid_Sans_Fallback_15x17,
+    &Font_Droid_Sans_Fallback_19x24,
+    &Font_Droid_Sans_Fallback_24x25,
+    &Font_Droid_Sans_Fallback_33x39,
+    &Font_Droid_Sans_Fallback_42x50,
+    &Font_Droid_Sans_Fallback_50x59,
+
+    &Font_Droid_Sans_13x16,
+    &Font_Droid_Sans_16x21,
+    &Font_Droid_Sans_19x25,
+    &Font_Droid_Sans_23x30,
+    &Font_Droid_Sans_27x35,
+    &Font_Droid_Sans_30x40,
+    &Font_Droid_Sans_34x44,
+    &Font_Droid_Sans_37x49,
+
+    &Font_Liberation_Mono_11x19,
+    &Font_Liberation_Mono_13x23,
+    &Font_Liberation_Mono_17x29,
+    &Font_Liberation_Mono_22x37,
+    &Font_Liberation_Mono_26x46,
+    &Font_Liberation_Mono_31x54,
+
+    &Font_7Seg_32x64,
+    &Font_7Seg_16x32,
+
+    &Font_Char_16x22
+};
+
+#define BuiltinFontCount ( ( int ) ( sizeof( BuiltinFonts ) / sizeof( BuiltinFonts[ 0 ] ) ) )
+
+/*
+ * Fonts added at runtime, ie. from font packs.
+ */
+static const struct TTFT_FontDef* RegisteredFonts[ TTFT_MaxRegisteredFonts ];
+static int RegisteredFontCount = 0;
+
+/*
+ * TTFT_FontRegister:
+ * Adds a font to the registry so TTFT_FontFind and friends will consider it.
+ * (Font) must stay valid until it is unregistered.
+ */
+bool TTFT_FontRegister( const struct TTFT_FontDef* Font ) {
+    NullCheck( Font, return false );
+
+    if ( RegisteredFontCount >= TTFT_MaxRegisteredFonts ) {
+        ESP_LOGE( __FUNCTION__, "No room to register %s", ( Font->FontName != NULL ) ? Font->FontName : "font" );
+        return false;
+    }
+
+    RegisteredFonts[ RegisteredFontCount++ ] = Font;
+    return true;
+}
+
+/*
+ * TTFT_FontUnregister:
+ * Removes a font added by TTFT_FontRegister.
+ */
+void TTFT_FontUnregister( const struct TTFT_FontDef* Font ) {
+    int i = 0;
+
+    for ( i = 0; i < RegisteredFontCount; i++ ) {
+        if ( RegisteredFonts[ i ] == Font ) {
+            memmove( &RegisteredFonts[ i ], &RegisteredFonts[ i + 1 ], sizeof( RegisteredFonts[ 0 ] ) * ( RegisteredFontCount - i - 1 ) );
+            RegisteredFontCount--;
+
+            return;
+        }
+    }
+}
+
+/*
+ * TTFT_FontGetCount:
+ * Number of fonts in the registry, compiled in fonts first followed by registered ones.
+ */
+int TTFT_FontGetCount( void ) {
+    return BuiltinFontCount + RegisteredFontCount;
+}
+
+/*
+ * TTFT_FontGetByIndex:
+ * Returns the registered font at (Index), or NULL if out of range.
+ */
+const struct TTFT_FontDef* TTFT_FontGetByIndex( int Index ) {
+    if ( Index < 0 || Index >= TTFT_FontGetCount( ) ) {
+        return NULL;
+    }
+
+    return ( Index < BuiltinFontCount ) ? BuiltinFonts[ Index ] : RegisteredFonts[ Index - BuiltinFontCount ];
+}
+
+/*
+ * TTFT_FontIsFamily:
+ * Returns true if (Font) belongs to (Family), ie. "droid sans" matches "droid sans 19x25"
+ * but not "droid sans fallback 19x24". Case insensitive, a NULL family matches everything.
+ */
+bool TTFT_FontIsFamily( const struct TTFT_FontDef* Font, const char* Family ) {
+    size_t Length = 0;
+
+    NullCheck( Font, return false );
+
+    if ( Family == NULL ) {
+        return true;
+    }
+
+    if ( Font->FontName == NULL ) {
+        return false;
+    }
+
+    Length = strlen( Family );
+
+    /* The family name must be followed by the size and nothing else */
+    return (
+        strncasecmp( Font->FontName, Family, Length ) == 0 &&
+        Font->FontName[ Length ] == ' ' &&
+        isdigit( ( unsigned char ) Font->FontName[ Length + 1 ] ) &&
+        strchr( &Font->FontName[ Length + 1 ], ' ' ) == NULL
+    );
+}
+
+/*
+ * TTFT_FontFind:
+ * Returns the tallest font in (Family) that is no taller than (MaxHeight),
+ * or NULL if there isn't one.
+ */
+const struct TTFT_FontDef* TTFT_FontFind( const char* Family, int MaxHeight ) {
+    return TTFT_FontFindFit( Family, NULL, 0, MaxHeight );
+}
+
+/*
+ * TTFT_FontFindFit:
+ * Returns the tallest font in (Family) no taller than (MaxHeight) in which (Text)
+ * is no wider than (MaxWidth), or NULL if the text will not fit in any of them.
+ * Pass MaxHeight <= 0 to only constrain the width.
+ */
+const struct TTFT_FontDef* TTFT_FontFindFit( const char* Family, const char* Text, int MaxWidth, int MaxHeight ) {
+    const struct TTFT_FontDef* Best = NULL;
+    const struct TTFT_FontDef* Font = NULL;
+    int Count = TTFT_FontGetCount( );
+    int i = 0;
+
+    for ( i = 0; i < Count; i++ ) {
+        Font = TTFT_FontGetByIndex( i );
+
+        if ( MaxHeight > 0 && Font->Height > MaxHeight ) {
+            continue;
+        }
+
+        /* Don't bother measuring anything that wouldn't beat what we already have */
+        if ( Best != NULL && ( Font->Height < Best->Height || ( Font->Height == Best->Height && Font->Width <= Best->Width ) ) ) {
+            continue;
+        }
+
+        if ( TTFT_FontIsFamily( Font, Family ) == false ) {
+            continue;
+        }
+
+        if ( Text != NULL && TTFT_FontMeasureStringWithFont( Font, Text ) > MaxWidth ) {
+            continue;
+        }
+
+        Best = Font;
+    }
+
+    return Best;
+}
@@ -0,0 +1,362 @@
+/**
+ * Copyright (c) 2018 Tara Keeling
+ * 
+ * This software is released under the MIT License.
+ * https://opensource.org/licenses/MIT
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "ttft.h"
+#include "ttft_font.h"
+#include "ttft_fontpack.h"
+
+#if ! defined ESP_PLATFORM
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+static size_t GetFontDataSize( const struct TTFT_FontDef* Font );
+static bool IsRangeInPack( struct TTFT_FontPack* Pack, uint32_t Offset, uint32_t Length );
+static bool TTFT_FontPackParse( struct TTFT_FontPack* Pack );
+
+/*
+ * GetFontDataSize:
+ * Size in bytes of the glyph table needed to cover the font's character range.
+ * The font must have already been checked to have StartChar <= EndChar.
+ */
+static size_t GetFontDataSize( const struct TTFT_FontDef* Font ) {
+    size_t GlyphCount = ( size_t ) ( Font->EndChar - Font->StartChar ) + 1;
+
+    return GlyphCount * ( ( ( size_t ) Font->Width * ( size_t ) TTFT_FontGetColumnBytes( Font ) ) + 1 );
+}
+
+/*
+ * IsRangeInPack:
+ * Returns true if (Length) bytes starting at (Offset) lie entirely within the pack.
+ */
+static bool IsRangeInPack( struct TTFT_FontPack* Pack, uint32_t Offset, uint32_t Length ) {
+    return Offset <= Pack->Size && Length <= Pack->Size - Offset;
+}
+
+/*
+ * TTFT_FontPackParse:
+ * Validates the mapped pack and fills in a font definition for each record.
+ */
+static bool TTFT_FontPackParse( struct TTFT_FontPack* Pack ) {
+    const struct TTFT_FontPackHeader* Header = NULL;
+    const struct TTFT_FontPackRecord* Record = NULL;
+    struct TTFT_FontDef* Font = NULL;
+    const char* Name = NULL;
+    int i = 0;
+
+    if ( Pack->Size < sizeof( struct TTFT_FontPackHeader ) ) {
+        ESP_LOGE( __FUNCTION__, "Font pack is too small" );
+        return false;
+    }
+
+    Header = ( const struct TTFT_FontPackHeader* ) Pack->Base;
+
+    if ( memcmp( Header->Magic, TTFT_FontPackMagic, sizeof( Header->Magic ) ) != 0 || Header->Version != TTFT_FontPackVersion ) {
+        ESP_LOGE( __FUNCTION__, "Not a font pack or unsupported version" );
+        return false;
+    }
+
+    if ( Header->Size > Pack->Size ) {
+        ESP_LOGE( __FUNCTION__, "Font pack is truncated, %u > %u", ( unsigned ) Header->Size, ( unsigned ) Pack->Size );
+        return false;
+    }
+
+    /* A partition is usually bigger than the pack inside of it */
+    Pack->Size = Header->Size;
+
+    CheckBounds( Header->FontCount, 0, TTFT_FontPackMaxFonts, return false );
+
+    if ( IsRangeInPack( Pack, sizeof( struct TTFT_FontPackHeader ), Header->FontCount * sizeof( struct TTFT_FontPackRecord ) ) == false ) {
+        ESP_LOGE( __FUNCTION__, "Font records run past the end of the pack" );
+        return false;
+    }
+
+    Record = ( const struct TTFT_FontPackRecord* ) &Header[ 1 ];
+
+    for ( i = 0; i < Header->FontCount; i++, Record++ ) {
+        Font = &Pack->Fonts[ i ];
+
+        if ( IsRangeInPack( Pack, Record->NameOffset, 1 ) == false ) {
+            ESP_LOGE( __FUNCTION__, "Font %d has a bad name", i );
+            return false;
+        }
+
+        Name = ( const char* ) &Pack->Base[ Record->NameOffset ];
+
+        if ( memchr( Name, 0, Pack->Size - Record->NameOffset ) == NULL ) {
+            ESP_LOGE( __FUNCTION__, "Font %d has a bad name", i );
+            return false;
+        }
+
+        /* Checked before anything is computed from them */
+        if ( Record->Width == 0 || Record->Width > TTFT_FontPackMaxGlyphSize || Record->Height == 0 || Record->Height > TTFT_FontPackMaxGlyphSize || Record->StartChar > Record->EndChar || Record->EndChar > 255 ) {
+            ESP_LOGE( __FUNCTION__, "Font %s has a bad size or character range", Name );
+            return false;
+        }
+
+        Font->FontName = Name;
+        Font->FontData = &Pack->Base[ Record->DataOffset ];
+        Font->Width = Record->Width;
+        Font->Height = Record->Height;
+        Font->StartChar = Record->StartChar;
+        Font->EndChar = Record->EndChar;
+        Font->IsMonospace = ( Record->IsMonospace != 0 );
+
+        if ( Record->DataSize < GetFontDataSize( Font ) || IsRangeInPack( Pack, Record->DataOffset, Record->DataSize ) == false ) {
+            ESP_LOGE( __FUNCTION__, "Font %s has bad glyph data", Name );
+            return false;
+        }
+    }
+
+    Pack->FontCount = Header->FontCount;
+    return true;
+}
+
+#if defined ESP_PLATFORM
+/*
+ * TTFT_FontPackOpenPartition:
+ * Maps the data partition with the given label and loads the font pack stored in it.
+ */
+bool TTFT_FontPackOpenPartition( struct TTFT_FontPack* Pack, const char* PartitionLabel ) {
+    const esp_partition_t* Partition = NULL;
+    const void* Ptr = NULL;
+
+    NullCheck( Pack, return false );
+    NullCheck( PartitionLabel, return false );
+
+    memset( Pack, 0, sizeof( struct TTFT_FontPack ) );
+
+    NullCheck( ( Partition = esp_partition_find_first( ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, PartitionLabel ) ), return false );
+    ESP_ERROR_CHECK_NONFATAL( esp_partition_mmap( Partition, 0, Partition->size, SPI_FLASH_MMAP_DATA, &Ptr, &Pack->MapHandle ), return false );
+
+    Pack->Base = ( const uint8_t* ) Ptr;
+    Pack->Size = Partition->size;
+    Pack->MappedSize = Partition->size;
+    Pack->IsMapped = true;
+
+    if ( TTFT_FontPackParse( Pack ) == false ) {
+        TTFT_FontPackClose( Pack );
+        return false;
+    }
+
+    return true;
+}
+#else
+/*
+ * TTFT_FontPackOpenFile:
+ * Maps the given file and loads the font pack stored in it.
+ */
+bool TTFT_FontPackOpenFile( struct TTFT_FontPack* Pack, const char* Path ) {
+    struct stat Info;
+    void* Ptr = NULL;
+    int FD = -1;
+
+    NullCheck( Pack, return false );
+    NullCheck( Path, return false );
+
+    memset( Pack, 0, sizeof( struct TTFT_FontPack ) );
+
+    if ( ( FD = open( Path, O_RDONLY ) ) < 0 ) {
+        ESP_LOGE( __FUNCTION__, "Failed to open %s", Path );
+        return false;
+    }
+
+    if ( fstat( FD, &Info ) != 0 || Info.st_size == 0 ) {
+        ESP_LOGE( __FUNCTION__, "Failed to stat %s", Path );
+        close( FD );
+
+        return false;
+    }
+
+    /* The mapping stays valid after the descriptor is closed */
+    Ptr = mmap( NULL, Info.st_size, PROT_READ, MAP_PRIVATE, FD, 0 );
+    close( FD );
+
+    if ( Ptr == MAP_FAILED ) {
+        ESP_LOGE( __FUNCTION__, "Failed to map %s", Path );
+        return false;
+    }
+
+    Pack->Base = ( const uint8_t* ) Ptr;
+    Pack->Size = Info.st_size;
+    Pack->MappedSize = Info.st_size;
+    Pack->IsMapped = true;
+
+    if ( TTFT_FontPackParse( Pack ) == false ) {
+        TTFT_FontPackClose( Pack );
+        return false;
+    }
+
+    return true;
+}
+#endif
+
+/*
+ * TTFT_FontPackOpenMemory:
+ * Loads a font pack that is already in memory, ie. embedded with EMBED_FILES.
+ * (Data) must stay valid for as long as the fonts are in use.
+ */
+bool TTFT_FontPackOpenMemory( struct TTFT_FontPack* Pack, const void* Data, size_t Size ) {
+    NullCheck( Pack, return false );
+    NullCheck( Data, return false );
+
+    memset( Pack, 0, sizeof( struct TTFT_FontPack ) );
+
+    Pack->Base = ( const uint8_t* ) Data;
+    Pack->Size = Size;
+
+    return TTFT_FontPackParse( Pack );
+}
+
+/*
+ * TTFT_FontPackClose:
+ * Unregisters the pack's fonts and unmaps it.
+ * None of the fonts in the pack may be used after this.
+ */
+void TTFT_FontPackClose( struct TTFT_FontPack* Pack ) {
+    int i = 0;
+
+    NullCheck( Pack, return );
+
+    for ( i = 0; i < Pack->FontCount; i++ ) {
+        TTFT_FontUnregister( &Pack->Fonts[ i ] );
+    }
+
+    if ( Pack->IsMapped == true ) {
+#if defined ESP_PLATFORM
+        spi_flash_munmap( Pack->MapHandle );
+#else
+        munmap( ( void* ) Pack->Base, Pack->MappedSize );
+#endif
+    }
+
+    memset( Pack, 0, sizeof( struct TTFT_FontPack ) );
+}
+
+/*
+ * TTFT_FontPackRegister:
+ * Adds every font in the pack to the font registry.
+ * If any of them can't be added none of them are.
+ */
+bool TTFT_FontPackRegister( struct TTFT_FontPack* Pack ) {
+    int i = 0;
+
+    NullCheck( Pack, return false );
+
+    for ( i = 0; i < Pack->FontCount; i++ ) {
+        if ( TTFT_FontRegister( &Pack->Fonts[ i ] ) == false ) {
+            while ( i-- > 0 ) {
+                TTFT_FontUnregister( &Pack->Fonts[ i ] );
+            }
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * TTFT_FontPackFind:
+ * Returns the font in the pack with the given name, or NULL if there isn't one.
+ */
+const struct TTFT_FontDef* TTFT_FontPackFind( struct TTFT_FontPack* Pack, const char* FontName ) {
+    int i = 0;
+
+    NullCheck( Pack, return NULL );
+    NullCheck( FontName, return NULL );
+
+    for ( i = 0; i < Pack->FontCount; i++ ) {
+        if ( strcmp( Pack->Fonts[ i ].FontName, FontName ) == 0 ) {
+            return &Pack->Fonts[ i ];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * TTFT_FontPackWrite:
+ * Writes the given fonts out as a font pack, ie. to build packs from the compiled in fonts.
+ */
+bool TTFT_FontPackWrite( const char* Path, const struct TTFT_FontDef* const* Fonts, int FontCount ) {
+    struct TTFT_FontPackHeader Header;
+    struct TTFT_FontPackRecord Record;
+    uint32_t Offset = 0;
+    bool Result = true;
+    FILE* Out = NULL;
+    int i = 0;
+
+    NullCheck( Path, return false );
+    NullCheck( Fonts, return false );
+    CheckBounds( FontCount, 1, TTFT_FontPackMaxFonts, return false );
+
+    NullCheck( ( Out = fopen( Path, "wb" ) ), return false );
+
+    /* Names and glyph data go after the header and records */
+    Offset = sizeof( Header ) + ( FontCount * sizeof( Record ) );
+
+    memset( &Header, 0, sizeof( Header ) );
+    memcpy( Header.Magic, TTFT_FontPackMagic, sizeof( Header.Magic ) );
+
+    Header.Version = TTFT_FontPackVersion;
+    Header.FontCount = FontCount;
+    Header.Size = Offset;
+
+    for ( i = 0; i < FontCount; i++ ) {
+        Header.Size+= strlen( Fonts[ i ]->FontName ) + 1;
+        Header.Size = ( Header.Size + 3 ) & ~3;
+        Header.Size+= GetFontDataSize( Fonts[ i ] );
+    }
+
+    Result&= ( fwrite( &Header, sizeof( Header ), 1, Out ) == 1 );
+
+    for ( i = 0; i < FontCount; i++ ) {
+        memset( &Record, 0, sizeof( Record ) );
+
+        Record.NameOffset = Offset;
+        Offset+= strlen( Fonts[ i ]->FontName ) + 1;
+        Offset = ( Offset + 3 ) & ~3;
+
+        Record.DataOffset = Offset;
+        Record.DataSize = GetFontDataSize( Fonts[ i ] );
+        Offset+= Record.DataSize;
+
+        Record.Width = Fonts[ i ]->Width;
+        Record.Height = Fonts[ i ]->Height;
+        Record.StartChar = Fonts[ i ]->StartChar;
+        Record.EndChar = Fonts[ i ]->EndChar;
+        Record.IsMonospace = ( Fonts[ i ]->IsMonospace == true ) ? 1 : 0;
+
+        Result&= ( fwrite( &Record, sizeof( Record ), 1, Out ) == 1 );
+    }
+
+    Offset = sizeof( Header ) + ( FontCount * sizeof( Record ) );
+
+    for ( i = 0; i < FontCount; i++ ) {
+        const uint32_t Zero = 0;
+        size_t NameLength = strlen( Fonts[ i ]->FontName ) + 1;
+        size_t Padding = ( ( ( Offset + NameLength + 3 ) & ~3 ) - ( Offset + NameLength ) );
+
+        Result&= ( fwrite( Fonts[ i ]->FontName, NameLength, 1, Out ) == 1 );
+        Result&= ( Padding == 0 || fwrite( &Zero, Padding, 1, Out ) == 1 );
+        Result&= ( fwrite( Fonts[ i ]->FontData, GetFontDataSize( Fonts[ i ] ), 1, Out ) == 1 );
+
+        Offset+= NameLength + Padding + GetFontDataSize( Fonts[ i ] );
+    }
+
+    Result&= ( fclose( Out ) == 0 );
+    return Result;
+}
@@ -0,0 +1,148 @@
+#ifndef _TTFT_FONTPACK_H_
+#define _TTFT_FONTPACK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "ttft_font.h"
+
+#if defined ESP_PLATFORM
+    #include "esp_partition.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Font packs let fonts live outside of the application image.
+ * 
+ * The pack is mapped straight into the address space (esp_partition_mmap on
+ * the ESP32, mmap on a host) and the font definitions point directly into the
+ * mapping, so glyph data is never copied into RAM.
+ * 
+ * Layout, all values little endian:
+ * 
+ * Header:
+ * 0    char[ 4 ]   Magic "TTFP"
+ * 4    uint16_t    Version (1)
+ * 6    uint16_t    Number of fonts
+ * 8    uint32_t    Size of the whole pack in bytes
+ * 12   uint32_t    Reserved, 0
+ * 
+ * Followed by one 32 byte record per font:
+ * 0    uint32_t    Offset of the nul terminated font name from the start of the pack
+ * 4    uint32_t    Offset of the glyph data, in the same layout as the compiled in fonts
+ * 8    uint32_t    Size of the glyph data
+ * 12   uint16_t    Width
+ * 14   uint16_t    Height
+ * 16   uint16_t    First character
+ * 18   uint16_t    Last character
+ * 20   uint8_t     1 if monospace
+ * 21   uint8_t[ 11 ] Reserved, 0
+ * 
+ * Names and glyph data follow in any order.
+ */
+
+#define TTFT_FontPackMagic "TTFP"
+#define TTFT_FontPackVersion 1
+
+/*
+ * Most fonts a single pack can hold.
+ */
+#define TTFT_FontPackMaxFonts 16
+
+/*
+ * Widest and tallest glyph a pack may hold, anything bigger is rejected as corrupt.
+ */
+#define TTFT_FontPackMaxGlyphSize 255
+
+struct TTFT_FontPackHeader {
+    char Magic[ 4 ];
+    uint16_t Version;
+    uint16_t FontCount;
+    uint32_t Size;
+    uint32_t Reserved;
+};
+
+struct TTFT_FontPackRecord {
+    uint32_t NameOffset;
+    uint32_t DataOffset;
+    uint32_t DataSize;
+    uint16_t Width;
+    uint16_t Height;
+    uint16_t StartChar;
+    uint16_t EndChar;
+    uint8_t IsMonospace;
+    uint8_t Reserved[ 11 ];
+};
+
+struct TTFT_FontPack {
+    const uint8_t* Base;
+    size_t Size;
+
+    /* How much was mapped, can be more than Size which only covers the pack itself */
+    size_t MappedSize;
+
+#if defined ESP_PLATFORM
+    spi_flash_mmap_handle_t MapHandle;
+#endif
+    bool IsMapped;
+
+    /* Only these small definitions live in RAM, they all point into the mapping */
+    struct TTFT_FontDef Fonts[ TTFT_FontPackMaxFonts ];
+    int FontCount;
+};
+
+#if defined ESP_PLATFORM
+/*
+ * TTFT_FontPackOpenPartition:
+ * Maps the data partition with the given label and loads the font pack stored in it.
+ */
+bool TTFT_FontPackOpenPartition( struct TTFT_FontPack* Pack, const char* PartitionLabel );
+#else
+/*
+ * TTFT_FontPackOpenFile:
+ * Maps the given file and loads the font pack stored in it.
+ */
+bool TTFT_FontPackOpenFile( struct TTFT_FontPack* Pack, const char* Path );
+#endif
+
+/*
+ * TTFT_FontPackOpenMemory:
+ * Loads a font pack that is already in memory, ie. embedded with EMBED_FILES.
+ * (Data) must stay valid for as long as the fonts are in use.
+ */
+bool TTFT_FontPackOpenMemory( struct TTFT_FontPack* Pack, const void* Data, size_t Size );
+
+/*
+ * TTFT_FontPackClose:
+ * Unregisters the pack's fonts and unmaps it.
+ * None of the fonts in the pack may be used after this.
+ */
+void TTFT_FontPackClose( struct TTFT_FontPack* Pack );
+
+/*
+ * TTFT_FontPackRegister:
+ * Adds every font in the pack to the font registry.
+ * If any of them can't be added none of them are.
+ */
+bool TTFT_FontPackRegister( struct TTFT_FontPack* Pack );
+
+/*
+ * TTFT_FontPackFind:
+ * Returns the font in the pack with the given name, or NULL if there isn't one.
+ */
+const struct TTFT_FontDef* TTFT_FontPackFind( struct TTFT_FontPack* Pack, const char* FontName );
+
+/*
+ * TTFT_FontPackWrite:
+ * Writes the given fonts out as a font pack, ie. to build packs from the compiled in fonts.
+ */
+bool TTFT_FontPackWrite( const char* Path, const struct TTFT_FontDef* const* Fonts, int FontCount );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
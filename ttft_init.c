@@ -0,0 +1,482 @@
+/**
+ * Copyright (c) 2018 Tara Keeling
+ *
+ * This software is released under the MIT License.
+ * https://opensource.org/licenses/MIT
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "ttft.h"
+
+/*
+ * Number of writes kept in flight by TTFT_RunInitTable.
+ * Must not be more than TTFT_TransportQueueDepth.
+ */
+#define InitQueueDepth 8
+
+/* Parameters get copied out of flash first, which is not DMA capable */
+#define InitMaxParams 16
+
+static TickType_t TTFT_InitMsToTicks( int Ms );
+static void TTFT_HardwareReset( struct TTFT_Device* DeviceHandle );
+static void TTFT_InitDrain( struct TTFT_Device* DeviceHandle, int Count );
+
+static const uint8_t InitTable_ST7735[ ] = {
+    /* Software reset, 5ms before the next command */
+    0x01, TTFT_InitDelay | 0, 5,
+
+    /* Sleep out no sooner than 120ms after reset */
+    0x11, TTFT_InitSince | TTFT_InitDelay | 0, 120, 5,
+
+    /* Gamma curve select */
+    0x26, 1, 0x04,
+
+    /* Depth */
+    0x3A, 1, TTFT_PixelFormat_RGB565,
+
+    /* madctl */
+    0x36, 1, 0x00,
+
+    /* Partial mode off */
+    0x13, 0,
+
+    /* Frame rate control */
+    0xB1, 3, 0x06, 0x01, 0x01,
+
+    /* Display on 120ms after sleep out */
+    0x29, TTFT_InitSince | 0, 120,
+
+    TTFT_InitEnd
+};
+
+/*
+ * TTFT Init sequence from fbcp-TTFT:
+ * https://github.com/juj/fbcp-TTFT
+ */
+static const uint8_t InitTable_ILI9341[ ] = {
+    /* Software reset, 5ms before the next command */
+    0x01, TTFT_InitDelay | 0, 5,
+
+    /* Display off */
+    0x28, 0,
+
+    /* Power control A */
+    0xCB, 5, 0x39, 0x2C, 0x00, 0x34, 0x02,
+
+    /* Power control B */
+    0xCF, 3, 0x00, 0xC1, 0x30,
+
+    /* Driver timing control A */
+    0xE8, 3, 0x85, 0x00, 0x78,
+
+    /* Driver timing control B */
+    0xEA, 2, 0x00, 0x00,
+
+    /* Power on sequence control */
+    0xED, 4, 0x64, 0x03, 0x12, 0x81,
+
+    /* Power control 1 */
+    0xC0, 1, 0x23,
+
+    /* Power control 2 */
+    0xC1, 1, 0x10,
+
+    /* VCOM control 1 */
+    0xC5, 2, 0x3E, 0x28,
+
+    /* VCOM control 2 */
+    0xC7, 1, 0x86,
+
+    /* madctl */
+    0x36, 1, 0x00,
+
+    /* Display inversion off */
+    0x20, 0,
+
+    /* Pixel format */
+    0x3A, 1, TTFT_PixelFormat_RGB565,
+
+    /* Frame rate control */
+    0xB1, 2, 0x00, 0x1B,
+
+    /* Display function control */
+    0xB6, 3, 0x08, 0x82, 0x27,
+
+    /* Enable 3G */
+    0xF2, 1, 0x02,
+
+    /* Gamma set */
+    0x26, 1, 0x01,
+
+    /* Positive gamma correction */
+    0xE0, 15,
+        0x0F, 0x31, 0x2B, 0x0C, 0x0E, 0x08, 0x4E, 0xF1,
+        0x37, 0x07, 0x10, 0x03, 0x0E, 0x09, 0x00,
+
+    /* Negative gamma correction */
+    0xE1, 15,
+        0x00, 0x0E, 0x14, 0x03, 0x11, 0x07, 0x31, 0xC1,
+        0x48, 0x08, 0x0F, 0x0C, 0x31, 0x36, 0x0F,
+
+    /* Sleep out no sooner than 120ms after reset */
+    0x11, TTFT_InitSince | TTFT_InitDelay | 0, 120, 5,
+
+    /* Display on 120ms after sleep out */
+    0x29, TTFT_InitSince | 0, 120,
+
+    TTFT_InitEnd
+};
+
+static const uint8_t InitTable_ST7789[ ] = {
+    /* Software reset, 5ms before the next command */
+    0x01, TTFT_InitDelay | 0, 5,
+
+    /* Sleep out no sooner than 120ms after reset */
+    0x11, TTFT_InitSince | TTFT_InitDelay | 0, 120, 5,
+
+    /* Pixel format */
+    0x3A, 1, TTFT_PixelFormat_RGB565,
+
+    /* madctl */
+    0x36, 1, 0x00,
+
+    /* Porch control */
+    0xB2, 5, 0x0C, 0x0C, 0x00, 0x33, 0x33,
+
+    /* Gate control */
+    0xB7, 1, 0x35,
+
+    /* VCOM setting */
+    0xBB, 1, 0x19,
+
+    /* LCM control */
+    0xC0, 1, 0x2C,
+
+    /* VDV and VRH command enable */
+    0xC2, 1, 0x01,
+
+    /* VRH set */
+    0xC3, 1, 0x12,
+
+    /* VDV set */
+    0xC4, 1, 0x20,
+
+    /* Frame rate control in normal mode, 60Hz */
+    0xC6, 1, 0x0F,
+
+    /* Power control 1 */
+    0xD0, 2, 0xA4, 0xA1,
+
+    /* Positive gamma correction */
+    0xE0, 14,
+        0xD0, 0x04, 0x0D, 0x11, 0x13, 0x2B, 0x3F,
+        0x54, 0x4C, 0x18, 0x0D, 0x0B, 0x1F, 0x23,
+
+    /* Negative gamma correction */
+    0xE1, 14,
+        0xD0, 0x04, 0x0C, 0x11, 0x13, 0x2C, 0x3F,
+        0x44, 0x51, 0x2F, 0x1F, 0x1F, 0x20, 0x23,
+
+    /* Display inversion on, most ST7789 panels are IPS and need it */
+    0x21, 0,
+
+    /* Normal display mode on */
+    0x13, 0,
+
+    /* Display on 120ms after sleep out */
+    0x29, TTFT_InitSince | 0, 120,
+
+    TTFT_InitEnd
+};
+
+/*
+ * The ILI9488 only supports 18 bit colour over SPI.
+ */
+static const uint8_t InitTable_ILI9488[ ] = {
+    /* Software reset, 5ms before the next command */
+    0x01, TTFT_InitDelay | 0, 5,
+
+    /* Positive gamma correction */
+    0xE0, 15,
+        0x00, 0x03, 0x09, 0x08, 0x16, 0x0A, 0x3F, 0x78,
+        0x4C, 0x09, 0x0A, 0x08, 0x16, 0x1A, 0x0F,
+
+    /* Negative gamma correction */
+    0xE1, 15,
+        0x00, 0x16, 0x19, 0x03, 0x0F, 0x05, 0x32, 0x45,
+        0x46, 0x04, 0x0E, 0x0D, 0x35, 0x37, 0x0F,
+
+    /* Power control 1 */
+    0xC0, 2, 0x17, 0x15,
+
+    /* Power control 2 */
+    0xC1, 1, 0x41,
+
+    /* VCOM control */
+    0xC5, 3, 0x00, 0x12, 0x80,
+
+    /* madctl */
+    0x36, 1, 0x48,
+
+    /* Pixel format, always 18 bit */
+    0x3A, 1, TTFT_PixelFormat_RGB666,
+
+    /* Interface mode control */
+    0xB0, 1, 0x00,
+
+    /* Frame rate control */
+    0xB1, 1, 0xA0,
+
+    /* Display inversion control */
+    0xB4, 1, 0x02,
+
+    /* Display function control */
+    0xB6, 3, 0x02, 0x02, 0x3B,
+
+    /* Entry mode set */
+    0xB7, 1, 0xC6,
+
+    /* Adjust control 3 */
+    0xF7, 4, 0xA9, 0x51, 0x2C, 0x82,
+
+    /* Sleep out no sooner than 120ms after reset */
+    0x11, TTFT_InitSince | TTFT_InitDelay | 0, 120, 5,
+
+    /* Display on 120ms after sleep out */
+    0x29, TTFT_InitSince | 0, 120,
+
+    TTFT_InitEnd
+};
+
+static const uint8_t InitTable_ILI9486[ ] = {
+    /* Software reset, 5ms before the next command */
+    0x01, TTFT_InitDelay | 0, 5,
+
+    /* Sleep out no sooner than 120ms after reset */
+    0x11, TTFT_InitSince | TTFT_InitDelay | 0, 120, 5,
+
+    /* Pixel format */
+    0x3A, 1, TTFT_PixelFormat_RGB565,
+
+    /* Power control 1 */
+    0xC0, 2, 0x0E, 0x0E,
+
+    /* Power control 2 */
+    0xC1, 2, 0x41, 0x00,
+
+    /* Power control 3 */
+    0xC2, 1, 0x55,
+
+    /* VCOM control */
+    0xC5, 4, 0x00, 0x00, 0x00, 0x00,
+
+    /* Positive gamma correction */
+    0xE0, 15,
+        0x0F, 0x1F, 0x1C, 0x0C, 0x0F, 0x08, 0x48, 0x98,
+        0x37, 0x0A, 0x13, 0x04, 0x11, 0x0D, 0x00,
+
+    /* Negative gamma correction */
+    0xE1, 15,
+        0x0F, 0x32, 0x2E, 0x0B, 0x0D, 0x05, 0x47, 0x75,
+        0x37, 0x06, 0x10, 0x03, 0x24, 0x20, 0x00,
+
+    /* Display inversion off */
+    0x20, 0,
+
+    /* madctl */
+    0x36, 1, 0x48,
+
+    /* Display on 120ms after sleep out */
+    0x29, TTFT_InitSince | 0, 120,
+
+    TTFT_InitEnd
+};
+
+/*
+ * TTFT_InitMsToTicks:
+ * Returns the number of ticks guaranteed to cover at least (Ms) milliseconds.
+ * pdMS_TO_TICKS rounds down and the first tick of a delay can be partial, so round up and add one.
+ */
+static TickType_t TTFT_InitMsToTicks( int Ms ) {
+    return ( ( Ms + portTICK_PERIOD_MS - 1 ) / portTICK_PERIOD_MS ) + 1;
+}
+
+/*
+ * TTFT_HardwareReset:
+ * Pulses the reset pin, if there is one.
+ * The controllers need a pulse of at least 10us and 5ms before they accept commands.
+ */
+static void TTFT_HardwareReset( struct TTFT_Device* DeviceHandle ) {
+    if ( DeviceHandle->ResetPin > -1 ) {
+        DeviceHandle->Ops->SetReset( DeviceHandle, false );
+        vTaskDelay( TTFT_InitMsToTicks( 1 ) );
+
+        DeviceHandle->Ops->SetReset( DeviceHandle, true );
+        vTaskDelay( TTFT_InitMsToTicks( 5 ) );
+    }
+}
+
+/*
+ * TTFT_InitDrain:
+ * Waits for (Count) queued writes to finish.
+ */
+static void TTFT_InitDrain( struct TTFT_Device* DeviceHandle, int Count ) {
+    for ( ; Count > 0; Count-- ) {
+        DeviceHandle->Ops->Wait( DeviceHandle );
+    }
+}
+
+/*
+ * TTFT_RunInitTable:
+ * Sends every command in (Table) to the display.
+ * Commands are queued back to back and only waited on when a delay is needed,
+ * the queue is full or the end of the table is reached.
+ */
+void TTFT_RunInitTable( struct TTFT_Device* DeviceHandle, const uint8_t* Table ) {
+    uint8_t Commands[ InitQueueDepth ];
+    uint8_t Params[ InitQueueDepth ][ InitMaxParams ];
+    TickType_t MarkTick = xTaskGetTickCount( );
+    TickType_t Elapsed = 0;
+    TickType_t Wait = 0;
+    int InFlight = 0;
+    int Count = 0;
+    int Flags = 0;
+    uint8_t Command = 0;
+
+    NullCheck( DeviceHandle, return );
+    NullCheck( Table, return );
+
+    while ( Table[ 1 ] != TTFT_InitEndMarker ) {
+        Command = *Table++;
+        Count = *Table & ~( TTFT_InitDelay | TTFT_InitSince );
+        Flags = *Table++ & ( TTFT_InitDelay | TTFT_InitSince );
+
+        CheckBounds( Count, 0, InitMaxParams, break );
+
+        if ( Flags & TTFT_InitSince ) {
+            /* Anything queued before this counts towards the wait, so drain first */
+            TTFT_InitDrain( DeviceHandle, InFlight );
+            InFlight = 0;
+
+            Elapsed = xTaskGetTickCount( ) - MarkTick;
+            Wait = TTFT_InitMsToTicks( Table[ Count ] );
+
+            if ( Elapsed < Wait ) {
+                vTaskDelay( Wait - Elapsed );
+            }
+        }
+
+        /* Room for both the command and its parameters? */
+        if ( InFlight + 2 > InitQueueDepth ) {
+            TTFT_InitDrain( DeviceHandle, InFlight );
+            InFlight = 0;
+        }
+
+        /* Every queued write uses its own slot until drained, the rest of the table can't be sent after a failure */
+        Commands[ InFlight ] = Command;
+
+        if ( DeviceHandle->Ops->Queue( DeviceHandle, &Commands[ InFlight ], 1, true ) == false ) {
+            ESP_LOGE( __func__, "Failed to queue command 0x%02X", Command );
+            break;
+        }
+
+        InFlight++;
+
+        if ( Count > 0 ) {
+            memcpy( Params[ InFlight ], Table, Count );
+
+            if ( Command == 0x3A ) {
+                Params[ InFlight ][ 0 ] = DeviceHandle->PixelFormat;
+            }
+
+            if ( Command == REG_MADCTL ) {
+                DeviceHandle->AddressMode = Params[ InFlight ][ 0 ];
+            }
+
+            if ( DeviceHandle->Ops->Queue( DeviceHandle, Params[ InFlight ], Count, false ) == false ) {
+                ESP_LOGE( __func__, "Failed to queue parameters of command 0x%02X", Command );
+                break;
+            }
+
+            InFlight++;
+        }
+
+        Table+= Count;
+        Table+= ( Flags & TTFT_InitSince ) ? 1 : 0;
+
+        if ( Flags & TTFT_InitDelay ) {
+            TTFT_InitDrain( DeviceHandle, InFlight );
+            InFlight = 0;
+
+            MarkTick = xTaskGetTickCount( );
+            vTaskDelay( TTFT_InitMsToTicks( *Table++ ) );
+        }
+    }
+
+    TTFT_InitDrain( DeviceHandle, InFlight );
+}
+
+/*
+ * TTFT_Reset_ST7735:
+ * Reset and init sequence for the ST7735 display controller.
+ */
+void TTFT_Reset_ST7735( struct TTFT_Device* DeviceHandle ) {
+    NullCheck( DeviceHandle, return );
+
+    TTFT_HardwareReset( DeviceHandle );
+    TTFT_RunInitTable( DeviceHandle, InitTable_ST7735 );
+}
+
+/*
+ * TTFT_Reset_ILI9341:
+ * Reset and init sequence for the ILI9341 display controller.
+ */
+void TTFT_Reset_ILI9341( struct TTFT_Device* DeviceHandle ) {
+    NullCheck( DeviceHandle, return );
+
+    TTFT_HardwareReset( DeviceHandle );
+    TTFT_RunInitTable( DeviceHandle, InitTable_ILI9341 );
+}
+
+/*
+ * TTFT_Reset_ST7789:
+ * Reset and init sequence for the ST7789 display controller.
+ */
+void TTFT_Reset_ST7789( struct TTFT_Device* DeviceHandle ) {
+    NullCheck( DeviceHandle, return );
+
+    TTFT_HardwareReset( DeviceHandle );
+    TTFT_RunInitTable( DeviceHandle, InitTable_ST7789 );
+}
+
+/*
+ * TTFT_Reset_ILI9488:
+ * Reset and init sequence for the ILI9488 display controller.
+ * Switches the device to 18 bit colour.
+ */
+void TTFT_Reset_ILI9488( struct TTFT_Device* DeviceHandle ) {
+    NullCheck( DeviceHandle, return );
+
+    /* Only 18 bit colour works over SPI, the palette gets converted on the next update */
+    DeviceHandle->PixelFormat = TTFT_PixelFormat_RGB666;
+
+    TTFT_HardwareReset( DeviceHandle );
+    TTFT_RunInitTable( DeviceHandle, InitTable_ILI9488 );
+}
+
+/*
+ * TTFT_Reset_ILI9486:
+ * Reset and init sequence for the ILI9486 display controller.
+ */
+void TTFT_Reset_ILI9486( struct TTFT_Device* DeviceHandle ) {
+    NullCheck( DeviceHandle, return );
+
+    TTFT_HardwareReset( DeviceHandle );
+    TTFT_RunInitTable( DeviceHandle, InitTable_ILI9486 );
+}
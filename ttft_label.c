@@ -0,0 +1,254 @@
+/**
+ * Copyright (c) 2018 Tara Keeling
+ * 
+ * This software is released under the MIT License.
+ * https://opensource.org/licenses/MIT
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "ttft.h"
+#include "ttft_font.h"
+#include "ttft_label.h"
+
+static bool IsLabelCurrent( struct TTFT_Device* DeviceHandle, struct TTFT_Label* Label, const char* Text );
+static bool TTFT_LabelRender( struct TTFT_Device* DeviceHandle, struct TTFT_Label* Label, const char* Text );
+static void IRAM_ATTR TTFT_LabelBlit( struct TTFT_Device* DeviceHandle, struct TTFT_Label* Label, int x, int y, uint8_t FGColor, uint8_t BGColor );
+
+/*
+ * IsLabelCurrent:
+ * Returns true if the cached bitmap still matches what would be rendered now.
+ */
+static bool IsLabelCurrent( struct TTFT_Device* DeviceHandle, struct TTFT_Label* Label, const char* Text ) {
+    return (
+        Label->IsValid == true &&
+        Label->Font == DeviceHandle->Font &&
+        Label->FontGetGlyphWidth == DeviceHandle->FontGetGlyphWidth &&
+        Label->FontScale == DeviceHandle->FontScale &&
+        strcmp( Label->Text, Text ) == 0
+    );
+}
+
+/*
+ * TTFT_LabelRender:
+ * Measures (Text) with the current font and renders it into the label's bitmap,
+ * taking a new one from the arena if the old one is too small.
+ */
+static bool TTFT_LabelRender( struct TTFT_Device* DeviceHandle, struct TTFT_Label* Label, const char* Text ) {
+    const struct TTFT_FontDef* Font = DeviceHandle->Font;
+    const uint8_t* GlyphData = NULL;
+    uint8_t* Row = NULL;
+    size_t Size = 0;
+    int Scale = DeviceHandle->FontScale;
+    int ColumnBytes = 0;
+    int LineWidth = 0;
+    int Width = 0;
+    int Lines = 1;
+    int CharWidth = 0;
+    int Column = 0;
+    int PenX = 0;
+    int PenY = 0;
+    int sx = 0;
+    int sy = 0;
+    int i = 0;
+    int j = 0;
+
+    Label->IsValid = false;
+
+    /* Measure first so we know how much to take from the arena */
+    for ( i = 0; Text[ i ] != 0; i++ ) {
+        if ( Text[ i ] == '\n' ) {
+            Width = ( LineWidth > Width ) ? LineWidth : Width;
+            LineWidth = 0;
+            Lines++;
+        }
+        else {
+            LineWidth+= TTFT_FontGetCharWidth( DeviceHandle, Text[ i ] );
+        }
+    }
+
+    Width = ( LineWidth > Width ) ? LineWidth : Width;
+
+    Label->Width = Width;
+    Label->Height = Lines * TTFT_FontGetHeight( DeviceHandle );
+    Label->LastLineWidth = LineWidth;
+    Label->Stride = ( Width + 7 ) / 8;
+
+    Size = Label->Stride * Label->Height;
+
+    if ( Size > Label->BitmapSize ) {
+        NullCheck( ( Label->Bitmap = TTFT_ArenaAlloc( Label->Arena, Size ) ), Label->BitmapSize = 0; return false );
+        Label->BitmapSize = Size;
+    }
+
+    if ( Size > 0 ) {
+        memset( Label->Bitmap, 0, Size );
+    }
+
+    ColumnBytes = TTFT_FontGetColumnBytes( Font );
+
+    for ( i = 0; Text[ i ] != 0; i++ ) {
+        if ( Text[ i ] == '\n' ) {
+            PenY+= TTFT_FontGetHeight( DeviceHandle );
+            PenX = 0;
+
+            continue;
+        }
+
+        if ( ( GlyphData = TTFT_FontGetGlyphData( Font, Text[ i ] ) ) == NULL ) {
+            continue;
+        }
+
+        CharWidth = DeviceHandle->FontGetGlyphWidth( Font, Text[ i ] );
+
+        /* Glyph data is column major, the bitmap is row major */
+        for ( Column = 0; Column < CharWidth && Column < Font->Width; Column++, PenX+= Scale ) {
+            for ( j = 0; j < Font->Height; j++ ) {
+                if ( ( GlyphData[ j / 8 ] & BIT( j & 0x07 ) ) == 0 ) {
+                    continue;
+                }
+
+                for ( sy = 0; sy < Scale; sy++ ) {
+                    Row = &Label->Bitmap[ ( PenY + ( j * Scale ) + sy ) * Label->Stride ];
+
+                    for ( sx = PenX; sx < PenX + Scale; sx++ ) {
+                        Row[ sx / 8 ] |= ( 0x80 >> ( sx & 0x07 ) );
+                    }
+                }
+            }
+
+            GlyphData+= ColumnBytes;
+        }
+
+        /* Fixed width mode may advance further than the glyph data */
+        PenX+= ( CharWidth - Column ) * Scale;
+    }
+
+    strcpy( Label->Text, Text );
+
+    Label->Font = Font;
+    Label->FontGetGlyphWidth = DeviceHandle->FontGetGlyphWidth;
+    Label->FontScale = Scale;
+    Label->IsValid = true;
+
+    return true;
+}
+
+/*
+ * TTFT_LabelBlit:
+ * Expands the label's 1bpp bitmap into the framebuffer, clipping to the screen.
+ * Whole bytes of set or clear pixels are written as a run.
+ */
+static void IRAM_ATTR TTFT_LabelBlit( struct TTFT_Device* DeviceHandle, struct TTFT_Label* Label, int x, int y, uint8_t FGColor, uint8_t BGColor ) {
+    const uint8_t* Src = NULL;
+    uint8_t* Dest = NULL;
+    uint8_t Color = 0;
+    uint8_t Bits = 0;
+    int StartCol = 0;
+    int StartRow = 0;
+    int EndCol = 0;
+    int EndRow = 0;
+    int Col = 0;
+    int Row = 0;
+
+    StartCol = ( x < 0 ) ? -x : 0;
+    StartRow = ( y < 0 ) ? -y : 0;
+
+    EndCol = ( x + Label->Width > DeviceHandle->Width ) ? DeviceHandle->Width - x : Label->Width;
+    EndRow = ( y + Label->Height > DeviceHandle->Height ) ? DeviceHandle->Height - y : Label->Height;
+
+    TTFT_MarkDirty( DeviceHandle, x + StartCol, y + StartRow, x + EndCol - 1, y + EndRow - 1 );
+
+    for ( Row = StartRow; Row < EndRow; Row++ ) {
+        Src = &Label->Bitmap[ Row * Label->Stride ];
+        Dest = &DeviceHandle->FrameBuffer[ ( ( y + Row ) * DeviceHandle->Width ) + x ];
+
+        for ( Col = StartCol; Col < EndCol; ) {
+            Bits = Src[ Col / 8 ];
+
+            if ( ( Col & 0x07 ) == 0 && ( Col + 8 ) <= EndCol && ( Bits == 0x00 || Bits == 0xFF ) ) {
+                Color = ( Bits == 0xFF ) ? FGColor : BGColor;
+
+                if ( Color != 255 ) {
+                    memset( &Dest[ Col ], Color, 8 );
+                }
+
+                Col+= 8;
+                continue;
+            }
+
+            Color = ( Bits & ( 0x80 >> ( Col & 0x07 ) ) ) ? FGColor : BGColor;
+
+            if ( Color != 255 ) {
+                Dest[ Col ] = Color;
+            }
+
+            Col++;
+        }
+    }
+}
+
+/*
+ * TTFT_LabelInit:
+ * Prepares a label to cache its bitmap in the given arena.
+ */
+void TTFT_LabelInit( struct TTFT_Label* Label, struct TTFT_Arena* Arena ) {
+    NullCheck( Label, return );
+    NullCheck( Arena, return );
+
+    memset( Label, 0, sizeof( struct TTFT_Label ) );
+    Label->Arena = Arena;
+}
+
+/*
+ * TTFT_LabelInvalidate:
+ * Forces the label to be rendered again on the next draw.
+ * Must be called for every label using an arena after it has been reset.
+ */
+void TTFT_LabelInvalidate( struct TTFT_Label* Label ) {
+    NullCheck( Label, return );
+
+    Label->IsValid = false;
+    Label->Bitmap = NULL;
+    Label->BitmapSize = 0;
+}
+
+/*
+ * TTFT_LabelDraw:
+ * Drop in replacement for TTFT_FontDrawString that renders (Text) with the current font
+ * only when something has changed since the last draw, otherwise it blits the cached bitmap.
+ * If the text is too long, the font is styled, the arena is full or the device is in immediate mode
+ * the string is drawn directly instead, so labels never blit without a framebuffer.
+ * 
+ * Returns the x coordinate just past the end of the last line, like TTFT_FontDrawString.
+ */
+int IRAM_ATTR TTFT_LabelDraw( struct TTFT_Device* DeviceHandle, struct TTFT_Label* Label, int x, int y, uint8_t FGColor, uint8_t BGColor, const char* Text ) {
+    NullCheck( DeviceHandle, return 0 );
+    CheckDrawTarget( DeviceHandle, return 0 );
+    NullCheck( DeviceHandle->Font, return 0 );
+    NullCheck( Label, return 0 );
+    NullCheck( Text, return 0 );
+
+    /* Styled text needs more than one bit per pixel and there is nothing to blit to in immediate mode */
+    if ( strlen( Text ) > TTFT_LabelMaxLength || DeviceHandle->FontStyle != FontStyle_Normal || DeviceHandle->IsImmediate == true ) {
+        Label->IsValid = false;
+        return TTFT_FontDrawString( DeviceHandle, x, y, FGColor, BGColor, Text );
+    }
+
+    if ( IsLabelCurrent( DeviceHandle, Label, Text ) == false ) {
+        if ( TTFT_LabelRender( DeviceHandle, Label, Text ) == false ) {
+            return TTFT_FontDrawString( DeviceHandle, x, y, FGColor, BGColor, Text );
+        }
+    }
+
+    if ( Label->Width == 0 ) {
+        return 0;
+    }
+
+    TTFT_LabelBlit( DeviceHandle, Label, x, y, FGColor, BGColor );
+    return x + Label->LastLineWidth;
+}
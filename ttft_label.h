@@ -0,0 +1,81 @@
+#ifndef _TTFT_LABEL_H_
+#define _TTFT_LABEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_attr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct TTFT_Device;
+struct TTFT_Arena;
+struct TTFT_FontDef;
+
+/*
+ * Longest string a label will cache, anything longer is drawn directly.
+ */
+#define TTFT_LabelMaxLength 47
+
+/*
+ * A label is a string that is rendered once into a 1bpp bitmap taken
+ * from an arena and then blitted into the framebuffer on every draw.
+ * 
+ * The cached bitmap is thrown away whenever the text, font, font width mode
+ * or font scale changes. Colours are applied at blit time so changing them costs nothing.
+ * 
+ * Note:
+ * An opaque background fills the whole bounding box of a multi line label,
+ * not just the width of each line.
+ */
+struct TTFT_Label {
+    struct TTFT_Arena* Arena;
+
+    const struct TTFT_FontDef* Font;
+    int ( *FontGetGlyphWidth ) ( const struct TTFT_FontDef*, char );
+    int FontScale;
+    char Text[ TTFT_LabelMaxLength + 1 ];
+
+    /* Row major, most significant bit first, (Stride) bytes per row */
+    uint8_t* Bitmap;
+    size_t BitmapSize;
+    int Stride;
+
+    int Width;
+    int Height;
+    int LastLineWidth;
+
+    bool IsValid;
+};
+
+/*
+ * TTFT_LabelInit:
+ * Prepares a label to cache its bitmap in the given arena.
+ */
+void TTFT_LabelInit( struct TTFT_Label* Label, struct TTFT_Arena* Arena );
+
+/*
+ * TTFT_LabelInvalidate:
+ * Forces the label to be rendered again on the next draw.
+ * Must be called for every label using an arena after it has been reset.
+ */
+void TTFT_LabelInvalidate( struct TTFT_Label* Label );
+
+/*
+ * TTFT_LabelDraw:
+ * Drop in replacement for TTFT_FontDrawString that renders (Text) with the current font
+ * only when something has changed since the last draw, otherwise it blits the cached bitmap.
+ * If the text is too long, the font is styled, the arena is full or the device is in immediate mode
+ * the string is drawn directly instead, so labels never blit without a framebuffer.
+ * 
+ * Returns the x coordinate just past the end of the last line, like TTFT_FontDrawString.
+ */
+int IRAM_ATTR TTFT_LabelDraw( struct TTFT_Device* DeviceHandle, struct TTFT_Label* Label, int x, int y, uint8_t FGColor, uint8_t BGColor, const char* Text );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
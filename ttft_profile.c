@@ -0,0 +1,130 @@
+/**
+ * Copyright (c) 2018 Tara Keeling
+ *
+ * This software is released under the MIT License.
+ * https://opensource.org/licenses/MIT
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "ttft.h"
+#include "ttft_profile.h"
+
+#if defined TTFT_PROFILE
+
+static const char* PrimitiveNames[ TTFT_Profile_Count ] = {
+    "TTFT_Clear",
+    "TTFT_PutPixel",
+    "TTFT_DrawHLine",
+    "TTFT_DrawVLine",
+    "TTFT_DrawLine",
+    "TTFT_FillRect",
+    "TTFT_DrawBox",
+    "TTFT_DrawBitmap",
+    "TTFT_PanelFillRect",
+    "TTFT_FontDrawChar",
+    "TTFT_FontDrawString",
+    "TTFT_FontDrawStringRotated",
+    "TTFT_FontDrawFixed",
+    "TTFT_Update",
+    "TTFT_UpdateRect",
+    "TTFT_UpdateDirty"
+};
+
+/* Shared by every device, drawing from more than one task at a time can lose counts */
+static DRAM_ATTR struct TTFT_ProfileCounter Counters[ TTFT_Profile_Count ];
+
+/*
+ * TTFT_ProfileEnd:
+ * Adds the call timed by (Scope) to its primitive, used by TTFT_Profile.
+ */
+void IRAM_ATTR TTFT_ProfileEnd( struct TTFT_ProfileScope* Scope ) {
+    struct TTFT_ProfileCounter* Counter = &Counters[ Scope->Primitive ];
+    uint32_t Cycles = TTFT_ProfileCycles( ) - Scope->Start;
+    int Bucket = 0;
+
+    /* Position of the highest set bit, counting from 1 */
+    Bucket = ( Cycles > 0 ) ? 32 - __builtin_clz( Cycles ) : 0;
+    Bucket = ( Bucket >= TTFT_ProfileBuckets ) ? TTFT_ProfileBuckets - 1 : Bucket;
+
+    Counter->Calls++;
+    Counter->Pixels+= Scope->Pixels;
+    Counter->Cycles+= Cycles;
+    Counter->Histogram[ Bucket ]++;
+}
+
+/*
+ * TTFT_ProfileGet:
+ * Copies the counters for (Primitive) into (OutCounter).
+ */
+bool TTFT_ProfileGet( TTFT_ProfilePrimitive Primitive, struct TTFT_ProfileCounter* OutCounter ) {
+    NullCheck( OutCounter, return false );
+    CheckBounds( Primitive, 0, TTFT_Profile_Count - 1, return false );
+
+    memcpy( OutCounter, &Counters[ Primitive ], sizeof( struct TTFT_ProfileCounter ) );
+    return true;
+}
+
+/*
+ * TTFT_ProfileReset:
+ * Zeroes the counters for every primitive.
+ */
+void TTFT_ProfileReset( void ) {
+    memset( Counters, 0, sizeof( Counters ) );
+}
+
+/*
+ * TTFT_ProfileReport:
+ * Prints a line for every primitive that was called, then its histogram.
+ */
+void TTFT_ProfileReport( FILE* fp ) {
+    struct TTFT_ProfileCounter* Counter = NULL;
+    int Bucket = 0;
+    int i = 0;
+
+    NullCheck( fp, return );
+
+    fprintf( fp, "%-28s %10s %12s %14s %12s %10s\n", "primitive", "calls", "pixels", "cycles", "cycles/call", "cycles/px" );
+
+    for ( i = 0; i < TTFT_Profile_Count; i++ ) {
+        Counter = &Counters[ i ];
+
+        if ( Counter->Calls == 0 ) {
+            continue;
+        }
+
+        fprintf( fp, "%-28s %10u %12llu %14llu %12.0f %10.2f\n",
+            PrimitiveNames[ i ],
+            ( unsigned ) Counter->Calls,
+            ( unsigned long long ) Counter->Pixels,
+            ( unsigned long long ) Counter->Cycles,
+            Counter->Cycles / ( double ) Counter->Calls,
+            ( Counter->Pixels > 0 ) ? Counter->Cycles / ( double ) Counter->Pixels : 0.0
+        );
+
+        /* Upper bound of each bucket that was hit and how many calls landed in it */
+        fprintf( fp, "%-28s", "" );
+
+        for ( Bucket = 0; Bucket < TTFT_ProfileBuckets; Bucket++ ) {
+            if ( Counter->Histogram[ Bucket ] == 0 ) {
+                continue;
+            }
+
+            if ( Bucket == TTFT_ProfileBuckets - 1 ) {
+                fprintf( fp, " >=%u:%u", 1U << ( Bucket - 1 ), ( unsigned ) Counter->Histogram[ Bucket ] );
+            }
+            else {
+                fprintf( fp, " <%u:%u", 1U << Bucket, ( unsigned ) Counter->Histogram[ Bucket ] );
+            }
+        }
+
+        fprintf( fp, "\n" );
+    }
+}
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef _TTFT_PROFILE_H_
+#define _TTFT_PROFILE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_attr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Draw call profiling, off unless TTFT_PROFILE is defined for the whole component
+ * (or CONFIG_TTFT_PROFILE is turned on in menuconfig).
+ * When it's off every macro here compiles to nothing.
+ *
+ * Each primitive counts its calls, the pixels it was asked to touch and the cycles it took,
+ * nanoseconds when not on the ESP32. Times include anything the primitive calls,
+ * so a TTFT_DrawBox is also counted in TTFT_DrawHLine and TTFT_DrawVLine.
+ * Wrappers that only call another primitive (TTFT_FontDrawInt, TTFT_FontDrawAnchoredString)
+ * show up as what they call.
+ */
+#if defined CONFIG_TTFT_PROFILE && ! defined TTFT_PROFILE
+    #define TTFT_PROFILE
+#endif
+
+typedef enum {
+    TTFT_Profile_Clear = 0,
+    TTFT_Profile_PutPixel,
+    TTFT_Profile_DrawHLine,
+    TTFT_Profile_DrawVLine,
+    TTFT_Profile_DrawLine,
+    TTFT_Profile_FillRect,
+    TTFT_Profile_DrawBox,
+    TTFT_Profile_DrawBitmap,
+    TTFT_Profile_PanelFillRect,
+    TTFT_Profile_FontDrawChar,
+    TTFT_Profile_FontDrawString,
+    TTFT_Profile_FontDrawStringRotated,
+    TTFT_Profile_FontDrawFixed,
+    TTFT_Profile_Update,
+    TTFT_Profile_UpdateRect,
+    TTFT_Profile_UpdateDirty,
+    TTFT_Profile_Count
+} TTFT_ProfilePrimitive;
+
+/*
+ * Histogram buckets for cycles per call.
+ * Bucket 0 counts zeros, bucket n counts calls that took from 2^(n-1) up to 2^n - 1
+ * and the last bucket counts everything longer than that.
+ */
+#define TTFT_ProfileBuckets 28
+
+struct TTFT_ProfileCounter {
+    uint32_t Calls;
+    uint64_t Pixels;
+    uint64_t Cycles;
+    uint32_t Histogram[ TTFT_ProfileBuckets ];
+};
+
+/*
+ * TTFT_ProfileCycles:
+ * Free running counter used for timing, CPU cycles on the ESP32 and nanoseconds anywhere else.
+ * Available whether or not profiling is on so benchmarks can use it too.
+ * ESP-IDF 5.0 renamed the cycle counter and moved it to esp_cpu.h, older releases
+ * ship an esp_cpu.h without it so go by the version rather than the header.
+ */
+#if defined ESP_PLATFORM
+    /* Releases before 4.0 don't have the version header */
+    #if __has_include( "esp_idf_version.h" )
+        #include "esp_idf_version.h"
+    #endif
+
+    #if defined ESP_IDF_VERSION
+        #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL( 5, 0, 0 )
+            #define TTFT_CycleCounterInCPU
+        #endif
+    #endif
+
+    #if defined TTFT_CycleCounterInCPU
+        #include "esp_cpu.h"
+        #define TTFT_ProfileCycles( ) ( ( uint32_t ) esp_cpu_get_cycle_count( ) )
+    #else
+        #include "xtensa/hal.h"
+        #define TTFT_ProfileCycles( ) ( ( uint32_t ) xthal_get_ccount( ) )
+    #endif
+#else
+    #include <time.h>
+
+    static inline uint32_t TTFT_ProfileNanoseconds( void ) {
+        struct timespec Now;
+
+        clock_gettime( CLOCK_MONOTONIC, &Now );
+        return ( uint32_t ) ( ( ( uint64_t ) Now.tv_sec * 1000000000 ) + Now.tv_nsec );
+    }
+
+    #define TTFT_ProfileCycles( ) TTFT_ProfileNanoseconds( )
+#endif
+
+#if defined TTFT_PROFILE
+
+/*
+ * Lives on the stack of a profiled primitive and records it when it goes out of scope,
+ * so every return is counted.
+ */
+struct TTFT_ProfileScope {
+    TTFT_ProfilePrimitive Primitive;
+    uint32_t Start;
+    uint32_t Pixels;
+};
+
+/*
+ * TTFT_ProfileEnd:
+ * Adds the call timed by (Scope) to its primitive, used by TTFT_Profile.
+ */
+void IRAM_ATTR TTFT_ProfileEnd( struct TTFT_ProfileScope* Scope );
+
+/*
+ * TTFT_ProfileGet:
+ * Copies the counters for (Primitive) into (OutCounter).
+ */
+bool TTFT_ProfileGet( TTFT_ProfilePrimitive Primitive, struct TTFT_ProfileCounter* OutCounter );
+
+/*
+ * TTFT_ProfileReset:
+ * Zeroes the counters for every primitive.
+ */
+void TTFT_ProfileReset( void );
+
+/*
+ * TTFT_ProfileReport:
+ * Prints a line for every primitive that was called, then its histogram.
+ */
+void TTFT_ProfileReport( FILE* fp );
+
+/* Put after the declarations of a primitive, times it from there to whichever return it leaves by */
+#define TTFT_Profile( Primitive ) \
+    struct TTFT_ProfileScope __ProfileScope __attribute__( ( cleanup( TTFT_ProfileEnd ) ) ) = { Primitive, TTFT_ProfileCycles( ), 0 }
+
+/* Adds to the number of pixels the current primitive touches */
+#define TTFT_ProfilePixels( Count ) __ProfileScope.Pixels+= ( Count )
+
+#else
+
+#define TTFT_Profile( Primitive )
+#define TTFT_ProfilePixels( Count )
+#define TTFT_ProfileGet( Primitive, OutCounter ) ( false )
+#define TTFT_ProfileReset( )
+#define TTFT_ProfileReport( fp )
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
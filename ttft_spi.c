@@ -0,0 +1,299 @@
+/**
+ * Copyright (c) 2018 Tara Keeling
+ * 
+ * This software is released under the MIT License.
+ * https://opensource.org/licenses/MIT
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "driver/spi_master.h"
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "ttft.h"
+#include "ttft_spi.h"
+
+#define MakeUser( Pin, Command ) ( ( Pin | ( Command << 8 ) ) )
+
+/*
+ * TTFT_ESP32SPI keeps the SPI device and one transaction for each write that can be queued.
+ */
+struct TTFT_SPIState {
+    spi_device_handle_t Handle;
+    spi_transaction_t Transactions[ TTFT_TransportQueueDepth ];
+    int Next;
+};
+
+static void IRAM_ATTR TTFT_PreTransferCallback( spi_transaction_t* Transaction );
+static void IRAM_ATTR TTFT_SPIPrepare( struct TTFT_Device* DeviceHandle, spi_transaction_t* Transaction, const uint8_t* Data, size_t Length, bool IsCommand );
+static bool TTFT_SPIOpen( struct TTFT_Device* DeviceHandle, void* Param );
+static void TTFT_SPIClose( struct TTFT_Device* DeviceHandle );
+static void IRAM_ATTR TTFT_SPIWriteBlocking( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t Length, bool IsCommand, bool Poll );
+static bool IRAM_ATTR TTFT_SPIQueue( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t Length, bool IsCommand );
+static void IRAM_ATTR TTFT_SPIWait( struct TTFT_Device* DeviceHandle );
+static void TTFT_SPISetReset( struct TTFT_Device* DeviceHandle, bool Level );
+static bool IRAM_ATTR TTFT_SPILock( struct TTFT_Device* DeviceHandle );
+static void IRAM_ATTR TTFT_SPIUnlock( struct TTFT_Device* DeviceHandle );
+
+const struct TTFT_TransportOps TTFT_ESP32SPI = {
+    .Open = TTFT_SPIOpen,
+    .Close = TTFT_SPIClose,
+    .Write = TTFT_SPIWriteBlocking,
+    .Queue = TTFT_SPIQueue,
+    .Wait = TTFT_SPIWait,
+    .SetReset = TTFT_SPISetReset,
+    .Lock = TTFT_SPILock,
+    .Unlock = TTFT_SPIUnlock
+};
+
+/*
+ * TTFT_PreTransferCallback:
+ * This manages the state of the data/command pin before SPI transfers.
+ */
+static void IRAM_ATTR TTFT_PreTransferCallback( spi_transaction_t* Transaction ) {
+    int DCState = 0;
+    int DCPin = 0;
+    int User = 0;
+    
+    if ( Transaction != NULL ) {
+        User = ( int ) Transaction->user;
+        DCState = ( User >> 8 ) & 0xFF;
+        DCPin = User & 0xFF;
+
+        gpio_set_level( DCPin, DCState );
+    }
+}
+
+/*
+ * SPIMasterInit:
+ * Initializes the SPI bus with the given pins.
+ */
+bool SPIMasterInit( int MOSIPin, int MISOPin, int SCLKPin ) {
+    const spi_bus_config_t SPIBusConfig = {
+        .mosi_io_num = MOSIPin,
+        .miso_io_num = MISOPin,
+        .sclk_io_num = SCLKPin,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .flags = SPICOMMON_BUSFLAG_NATIVE_PINS,
+        .max_transfer_sz = 16384 * 8
+    };
+
+    ESP_ERROR_CHECK_NONFATAL( spi_bus_initialize( VSPI_HOST, &SPIBusConfig, 1 ), return false );
+    return true;
+}
+
+/*
+ * Initializes and resets the LCD device connected to the given GPIO pins.
+ * 
+ * Required parameters:
+ * Width:   Width of the Display
+ * Height:  Height of the display
+ * DCPin:   Data/command selection pin
+ * 
+ * Optional parameters:
+ * CSPin:           Can be held low if nothing else will be on the SPI bus
+ * ResetPin:        Can be held high to skip hardware reset, TTFT_Reset will still reset the device in software.
+ * BacklightPin:    Can be held high to be always on or if you're going to manage it yourself.
+ * ResetProc:       Pointer to device specific reset function which should send commands needed to initialize the display.
+ * SPIFrequency:    Frequency in Hz to drive the SPI display at.
+ */
+bool TTFT_Init( struct TTFT_Device* DeviceHandle, int Width, int Height, int CSPin, int DCPin, int ResetPin, int BacklightPin, void ( *ResetProc ) ( struct TTFT_Device* ), int SPIFrequency ) {
+    return TTFT_InitEx( DeviceHandle, Width, Height, CSPin, DCPin, ResetPin, BacklightPin, ResetProc, SPIFrequency, TTFT_InitFlag_Default );
+}
+
+/*
+ * TTFT_InitEx:
+ * Same as TTFT_Init with extra TTFT_InitFlags.
+ * 
+ * With TTFT_InitFlag_Async the display is reset in a background task while the caller carries on,
+ * drawing into the framebuffer is fine right away and updates wait for the display to be ready.
+ */
+bool TTFT_InitEx( struct TTFT_Device* DeviceHandle, int Width, int Height, int CSPin, int DCPin, int ResetPin, int BacklightPin, void ( *ResetProc ) ( struct TTFT_Device* ), int SPIFrequency, int Flags ) {
+    struct TTFT_SPIConfig Config = {
+        .CSPin = CSPin,
+        .DCPin = DCPin,
+        .ResetPin = ResetPin,
+        .Frequency = SPIFrequency
+    };
+
+    return TTFT_InitTransport( DeviceHandle, Width, Height, BacklightPin, &TTFT_ESP32SPI, &Config, ResetProc, Flags );
+}
+
+/*
+ * TTFT_SPIOpen:
+ * Sets up the D/C and reset pins and adds the display to the SPI bus.
+ * (Param) points to a struct TTFT_SPIConfig.
+ */
+static bool TTFT_SPIOpen( struct TTFT_Device* DeviceHandle, void* Param ) {
+    struct TTFT_SPIConfig* Config = ( struct TTFT_SPIConfig* ) Param;
+    spi_device_interface_config_t SPIDeviceConfig;
+    struct TTFT_SPIState* State = NULL;
+    gpio_config_t IOOutputs = {
+        .pin_bit_mask = 0,
+        .mode = GPIO_MODE_OUTPUT
+    };
+
+    NullCheck( Config, return false );
+
+    if ( Config->DCPin == -1 ) {
+        ESP_LOGE( __FUNCTION__, "Need a D/C pin to function properly!" );
+        return false;
+    }
+
+    memset( &SPIDeviceConfig, 0, sizeof( SPIDeviceConfig ) );
+
+    SPIDeviceConfig.clock_speed_hz = Config->Frequency;
+    SPIDeviceConfig.spics_io_num = Config->CSPin;
+    SPIDeviceConfig.queue_size = TTFT_TransportQueueDepth;
+    SPIDeviceConfig.flags = SPI_DEVICE_HALFDUPLEX;
+    SPIDeviceConfig.pre_cb = TTFT_PreTransferCallback;
+
+    DeviceHandle->CSPin = Config->CSPin;
+    DeviceHandle->DCPin = Config->DCPin;
+    DeviceHandle->ResetPin = Config->ResetPin;
+
+    IOOutputs.pin_bit_mask |= ( 1ULL << Config->DCPin );
+    IOOutputs.pin_bit_mask |= ( Config->ResetPin > -1 ) ? ( 1ULL << Config->ResetPin ) : 0;
+
+    /* Set default values for gpio outputs, the reset pin must not go low under a display resumed from sleep */
+    if ( Config->ResetPin > -1 ) {
+        gpio_set_level( Config->ResetPin, 1 );
+    }
+
+    gpio_set_level( Config->DCPin, 0 );
+
+    ESP_ERROR_CHECK_NONFATAL( gpio_config( &IOOutputs ), return false );
+
+    if ( Config->ResetPin > -1 ) {
+        /* Let go of the pin if TTFT_Sleep held it through deep sleep */
+        ESP_ERROR_CHECK_NONFATAL( gpio_hold_dis( Config->ResetPin ), return false );
+    }
+
+    NullCheck( ( State = malloc( sizeof( struct TTFT_SPIState ) ) ), return false );
+    memset( State, 0, sizeof( struct TTFT_SPIState ) );
+
+    ESP_ERROR_CHECK_NONFATAL( spi_bus_add_device( VSPI_HOST, &SPIDeviceConfig, &State->Handle ), free( State ); return false );
+
+    DeviceHandle->TransportState = State;
+    return true;
+}
+
+/*
+ * TTFT_SPIClose:
+ * Takes the display off the SPI bus.
+ */
+static void TTFT_SPIClose( struct TTFT_Device* DeviceHandle ) {
+    struct TTFT_SPIState* State = ( struct TTFT_SPIState* ) DeviceHandle->TransportState;
+
+    if ( State != NULL ) {
+        ESP_ERROR_CHECK_NONFATAL( spi_bus_remove_device( State->Handle ), return );
+        free( State );
+    }
+
+    DeviceHandle->TransportState = NULL;
+}
+
+/*
+ * TTFT_SPIPrepare:
+ * Fills in a transaction, writes of 4 bytes or less are copied into it.
+ */
+static void IRAM_ATTR TTFT_SPIPrepare( struct TTFT_Device* DeviceHandle, spi_transaction_t* Transaction, const uint8_t* Data, size_t Length, bool IsCommand ) {
+    memset( Transaction, 0, sizeof( spi_transaction_t ) );
+
+    Transaction->length = Length * 8;
+    Transaction->user = ( void* ) MakeUser( DeviceHandle->DCPin, ( IsCommand == true ) ? 0 : 1 );
+
+    /* Saves the DMA setup and works with data that isn't DMA capable (ie. in flash) */
+    if ( Length <= sizeof( Transaction->tx_data ) ) {
+        Transaction->flags = SPI_TRANS_USE_TXDATA;
+        memcpy( Transaction->tx_data, Data, Length );
+    }
+    else {
+        Transaction->tx_buffer = Data;
+    }
+}
+
+/*
+ * TTFT_SPIWriteBlocking:
+ * Sends a write and waits for it to finish, busy waiting if (Poll) is true or sleeping on the interrupt if not.
+ * Nothing may be queued when this is called.
+ */
+static void IRAM_ATTR TTFT_SPIWriteBlocking( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t Length, bool IsCommand, bool Poll ) {
+    struct TTFT_SPIState* State = ( struct TTFT_SPIState* ) DeviceHandle->TransportState;
+    spi_transaction_t SPITrans;
+
+    TTFT_SPIPrepare( DeviceHandle, &SPITrans, Data, Length, IsCommand );
+
+    if ( Poll == true ) {
+        ESP_ERROR_CHECK_NONFATAL( spi_device_polling_transmit( State->Handle, &SPITrans ), return );
+    }
+    else {
+        ESP_ERROR_CHECK_NONFATAL( spi_device_transmit( State->Handle, &SPITrans ), return );
+    }
+}
+
+/*
+ * TTFT_SPIQueue:
+ * Queues a write for DMA and returns without waiting, (Data) must stay put until TTFT_SPIWait says it's done.
+ * Returns false if the SPI driver would not take it.
+ */
+static bool IRAM_ATTR TTFT_SPIQueue( struct TTFT_Device* DeviceHandle, const uint8_t* Data, size_t Length, bool IsCommand ) {
+    struct TTFT_SPIState* State = ( struct TTFT_SPIState* ) DeviceHandle->TransportState;
+    spi_transaction_t* Trans = &State->Transactions[ State->Next ];
+
+    /* Callers never have more than TTFT_TransportQueueDepth queued so this slot is free */
+    State->Next = ( State->Next + 1 ) % TTFT_TransportQueueDepth;
+
+    TTFT_SPIPrepare( DeviceHandle, Trans, Data, Length, IsCommand );
+
+    ESP_ERROR_CHECK_NONFATAL( spi_device_queue_trans( State->Handle, Trans, portMAX_DELAY ), return false );
+    return true;
+}
+
+/*
+ * TTFT_SPIWait:
+ * Waits for the oldest queued write to finish.
+ */
+static void IRAM_ATTR TTFT_SPIWait( struct TTFT_Device* DeviceHandle ) {
+    struct TTFT_SPIState* State = ( struct TTFT_SPIState* ) DeviceHandle->TransportState;
+    spi_transaction_t* Result = NULL;
+
+    ESP_ERROR_CHECK_NONFATAL( spi_device_get_trans_result( State->Handle, &Result, portMAX_DELAY ), return );
+}
+
+/*
+ * TTFT_SPISetReset:
+ * Drives the reset pin to (Level) if there is one, low holds the display in reset.
+ */
+static void TTFT_SPISetReset( struct TTFT_Device* DeviceHandle, bool Level ) {
+    if ( DeviceHandle->ResetPin > -1 ) {
+        ESP_ERROR_CHECK_NONFATAL( gpio_set_level( DeviceHandle->ResetPin, ( Level == true ) ? 1 : 0 ), return );
+    }
+}
+
+/*
+ * TTFT_SPILock:
+ * Takes the SPI bus for the display so other devices on it wait, returns false if that failed.
+ */
+static bool IRAM_ATTR TTFT_SPILock( struct TTFT_Device* DeviceHandle ) {
+    struct TTFT_SPIState* State = ( struct TTFT_SPIState* ) DeviceHandle->TransportState;
+
+    ESP_ERROR_CHECK_NONFATAL( spi_device_acquire_bus( State->Handle, portMAX_DELAY ), return false );
+    return true;
+}
+
+/*
+ * TTFT_SPIUnlock:
+ * Gives the SPI bus back after TTFT_SPILock.
+ */
+static void IRAM_ATTR TTFT_SPIUnlock( struct TTFT_Device* DeviceHandle ) {
+    struct TTFT_SPIState* State = ( struct TTFT_SPIState* ) DeviceHandle->TransportState;
+
+    spi_device_release_bus( State->Handle );
+}
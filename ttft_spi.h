@@ -0,0 +1,33 @@
+#ifndef _TTFT_SPI_H_
+#define _TTFT_SPI_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct TTFT_TransportOps;
+
+/*
+ * Passed to TTFT_InitTransport when opening TTFT_ESP32SPI.
+ * Pins can be -1 except for (DCPin), see TTFT_Init.
+ */
+struct TTFT_SPIConfig {
+    int CSPin;
+    int DCPin;
+    int ResetPin;
+    int Frequency;
+};
+
+/*
+ * Transport for displays on the ESP32 SPI master, SPIMasterInit must be called first.
+ */
+extern const struct TTFT_TransportOps TTFT_ESP32SPI;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) 2018 Tara Keeling
+ * 
+ * This software is released under the MIT License.
+ * https://opensource.org/licenses/MIT
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "ttft.h"
+#include "ttft_font.h"
+#include "ttft_textfield.h"
+
+static void FillClipped( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1, uint8_t Color );
+
+/*
+ * FillClipped:
+ * TTFT_FillRect that quietly clips to the screen instead of rejecting offscreen coordinates.
+ */
+static void FillClipped( struct TTFT_Device* DeviceHandle, int x0, int y0, int x1, int y1, uint8_t Color ) {
+    x0 = ( x0 < 0 ) ? 0 : x0;
+    y0 = ( y0 < 0 ) ? 0 : y0;
+    x1 = ( x1 >= DeviceHandle->Width ) ? DeviceHandle->Width - 1 : x1;
+    y1 = ( y1 >= DeviceHandle->Height ) ? DeviceHandle->Height - 1 : y1;
+
+    if ( x0 <= x1 && y0 <= y1 ) {
+        TTFT_FillRect( DeviceHandle, x0, y0, x1, y1, Color );
+    }
+}
+
+/*
+ * TTFT_TextFieldInit:
+ * Sets the position of a text field, it will be fully drawn on the next TTFT_TextFieldSet.
+ */
+void TTFT_TextFieldInit( struct TTFT_TextField* Field, int x, int y ) {
+    NullCheck( Field, return );
+
+    memset( Field, 0, sizeof( struct TTFT_TextField ) );
+
+    Field->x = x;
+    Field->y = y;
+}
+
+/*
+ * TTFT_TextFieldInvalidate:
+ * Forces the whole field to be redrawn on the next TTFT_TextFieldSet.
+ * Call this if something else has drawn over the field.
+ */
+void TTFT_TextFieldInvalidate( struct TTFT_TextField* Field ) {
+    NullCheck( Field, return );
+
+    Field->IsValid = false;
+}
+
+/*
+ * TTFT_TextFieldSet:
+ * Changes the text of the field using the current font, only drawing the characters that changed.
+ * Any area left behind by a shorter string is filled with (BGColor).
+ * 
+ * Returns the number of characters that were drawn.
+ */
+int IRAM_ATTR TTFT_TextFieldSet( struct TTFT_Device* DeviceHandle, struct TTFT_TextField* Field, uint8_t FGColor, uint8_t BGColor, const char* Text ) {
+    const struct TTFT_FontDef* Font = NULL;
+    int CharX[ TTFT_TextFieldMaxLength + 1 ];
+    bool FullRedraw = false;
+    int Redrawn = 0;
+    int OldEnd = 0;
+    int Length = 0;
+    int PenX = 0;
+    int i = 0;
+
+    NullCheck( DeviceHandle, return 0 );
+    CheckDrawTarget( DeviceHandle, return 0 );
+    NullCheck( DeviceHandle->Font, return 0 );
+    NullCheck( Field, return 0 );
+    NullCheck( Text, return 0 );
+
+    if ( BGColor == 255 ) {
+        ESP_LOGE( __FUNCTION__, "Text fields need a solid background colour" );
+        return 0;
+    }
+
+    Font = DeviceHandle->Font;
+
+    FullRedraw = (
+        Field->IsValid == false ||
+        Field->Font != Font ||
+        Field->FontGetGlyphWidth != DeviceHandle->FontGetGlyphWidth ||
+        Field->FontScale != DeviceHandle->FontScale ||
+        Field->FontStyle != DeviceHandle->FontStyle ||
+        Field->FontOutlineColor != DeviceHandle->FontOutlineColor ||
+        Field->FontShadowColor != DeviceHandle->FontShadowColor ||
+        Field->FGColor != FGColor ||
+        Field->BGColor != BGColor
+    );
+
+    if ( FullRedraw == true && Field->IsValid == true ) {
+        /* Erase what the old font left behind */
+        FillClipped( DeviceHandle, Field->x, Field->y, Field->CharX[ Field->Length ] - 1, Field->y + Field->Height - 1, BGColor );
+    }
+
+    OldEnd = ( FullRedraw == true ) ? Field->x : Field->CharX[ Field->Length ];
+
+    /* Lay out the new string */
+    for ( PenX = Field->x, Length = 0; Text[ Length ] != 0 && Length < TTFT_TextFieldMaxLength; Length++ ) {
+        CharX[ Length ] = PenX;
+        PenX+= TTFT_FontGetCharWidth( DeviceHandle, Text[ Length ] );
+    }
+
+    CharX[ Length ] = PenX;
+
+    for ( i = 0; i < Length; i++ ) {
+        /* Same character in the same place, nothing to do */
+        if ( FullRedraw == false && i < Field->Length && Text[ i ] == Field->Text[ i ] && CharX[ i ] == Field->CharX[ i ] ) {
+            continue;
+        }
+
+        if ( CharX[ i + 1 ] > CharX[ i ] ) {
+            TTFT_FontDrawChar( DeviceHandle, Text[ i ], CharX[ i ], Field->y, FGColor, BGColor );
+            Redrawn++;
+        }
+    }
+
+    /* Erase the tail of a string that got shorter */
+    if ( CharX[ Length ] < OldEnd ) {
+        FillClipped( DeviceHandle, CharX[ Length ], Field->y, OldEnd - 1, Field->y + TTFT_FontGetHeight( DeviceHandle ) - 1, BGColor );
+    }
+
+    memcpy( Field->Text, Text, Length );
+    memcpy( Field->CharX, CharX, sizeof( int ) * ( Length + 1 ) );
+
+    Field->Text[ Length ] = 0;
+    Field->Length = Length;
+    Field->Font = Font;
+    Field->FontGetGlyphWidth = DeviceHandle->FontGetGlyphWidth;
+    Field->FontScale = DeviceHandle->FontScale;
+    Field->FontStyle = DeviceHandle->FontStyle;
+    Field->FontOutlineColor = DeviceHandle->FontOutlineColor;
+    Field->FontShadowColor = DeviceHandle->FontShadowColor;
+    Field->Height = TTFT_FontGetHeight( DeviceHandle );
+    Field->FGColor = FGColor;
+    Field->BGColor = BGColor;
+    Field->IsValid = true;
+
+    return Redrawn;
+}
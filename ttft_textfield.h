@@ -0,0 +1,79 @@
+#ifndef _TTFT_TEXTFIELD_H_
+#define _TTFT_TEXTFIELD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_attr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct TTFT_Device;
+struct TTFT_FontDef;
+
+/*
+ * Longest string a text field can hold, anything past this is cut off.
+ */
+#define TTFT_TextFieldMaxLength 31
+
+/*
+ * A text field remembers the string it last drew and where each character went
+ * so that updating it only redraws (and marks dirty) the character cells that changed.
+ * 
+ * Monospace fonts only redraw the characters that differ.
+ * Proportional fonts redraw from the first differing character onward since
+ * everything after it may have moved.
+ * 
+ * Text fields are a single line and need a solid background colour to erase old characters.
+ */
+struct TTFT_TextField {
+    int x;
+    int y;
+
+    const struct TTFT_FontDef* Font;
+    int ( *FontGetGlyphWidth ) ( const struct TTFT_FontDef*, char );
+    int FontScale;
+    int FontStyle;
+    uint8_t FontOutlineColor;
+    uint8_t FontShadowColor;
+    int Height;
+    uint8_t FGColor;
+    uint8_t BGColor;
+
+    char Text[ TTFT_TextFieldMaxLength + 1 ];
+
+    /* Left edge of each character, CharX[ Length ] is the end of the string */
+    int CharX[ TTFT_TextFieldMaxLength + 1 ];
+    int Length;
+
+    bool IsValid;
+};
+
+/*
+ * TTFT_TextFieldInit:
+ * Sets the position of a text field, it will be fully drawn on the next TTFT_TextFieldSet.
+ */
+void TTFT_TextFieldInit( struct TTFT_TextField* Field, int x, int y );
+
+/*
+ * TTFT_TextFieldInvalidate:
+ * Forces the whole field to be redrawn on the next TTFT_TextFieldSet.
+ * Call this if something else has drawn over the field.
+ */
+void TTFT_TextFieldInvalidate( struct TTFT_TextField* Field );
+
+/*
+ * TTFT_TextFieldSet:
+ * Changes the text of the field using the current font, only drawing the characters that changed.
+ * Any area left behind by a shorter string is filled with (BGColor).
+ * 
+ * Returns the number of characters that were drawn.
+ */
+int IRAM_ATTR TTFT_TextFieldSet( struct TTFT_Device* DeviceHandle, struct TTFT_TextField* Field, uint8_t FGColor, uint8_t BGColor, const char* Text );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,244 @@
+/**
+ * Copyright (c) 2018 Tara Keeling
+ *
+ * This software is released under the MIT License.
+ * https://opensource.org/licenses/MIT
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "ttft.h"
+#include "ttft_trace.h"
+
+static struct TTFT_TraceEntry* TTFT_TraceCopy( struct TTFT_Device* DeviceHandle, int* OutCount );
+
+/*
+ * TTFT_TraceStart:
+ * Starts recording every transfer to (DeviceHandle) into (Entries), which holds (Count) of them
+ * and must stay around until TTFT_TraceStop. Once full the oldest entries are overwritten.
+ * Don't call this while an update is running.
+ */
+void TTFT_TraceStart( struct TTFT_Device* DeviceHandle, struct TTFT_TraceEntry* Entries, int Count ) {
+    NullCheck( DeviceHandle, return );
+    NullCheck( Entries, return );
+    CheckBounds( Count, TTFT_TraceMinEntries, INT32_MAX, return );
+
+    DeviceHandle->Trace = NULL;
+
+    memset( Entries, 0, Count * sizeof( struct TTFT_TraceEntry ) );
+
+    DeviceHandle->TraceSize = Count;
+    DeviceHandle->TraceHead = 0;
+    DeviceHandle->TraceDone = 0;
+
+    /* Recording starts once the rest is set up */
+    __atomic_store_n( &DeviceHandle->Trace, Entries, __ATOMIC_RELEASE );
+}
+
+/*
+ * TTFT_TraceStop:
+ * Stops recording, (Entries) given to TTFT_TraceStart can be reused after this.
+ * Don't call this while an update is running, it could still be writing to (Entries).
+ */
+void TTFT_TraceStop( struct TTFT_Device* DeviceHandle ) {
+    NullCheck( DeviceHandle, return );
+
+    __atomic_store_n( &DeviceHandle->Trace, NULL, __ATOMIC_RELEASE );
+}
+
+/*
+ * TTFT_TraceGet:
+ * Copies up to (MaxEntries) of the most recent entries into (OutEntries), oldest first.
+ * Safe to call while the display is being updated from another task, entries that got
+ * overwritten during the copy are left out and transfers that finished during the copy
+ * are shown as still in flight.
+ * Returns the number of entries copied.
+ */
+int TTFT_TraceGet( struct TTFT_Device* DeviceHandle, struct TTFT_TraceEntry* OutEntries, int MaxEntries ) {
+    struct TTFT_TraceEntry* Trace = NULL;
+    uint32_t Oldest = 0;
+    uint32_t First = 0;
+    uint32_t Count = 0;
+    uint32_t Head = 0;
+    uint32_t Done = 0;
+    uint32_t Size = 0;
+    uint32_t i = 0;
+
+    NullCheck( DeviceHandle, return 0 );
+    NullCheck( OutEntries, return 0 );
+
+    if ( ( Trace = __atomic_load_n( &DeviceHandle->Trace, __ATOMIC_ACQUIRE ) ) == NULL || MaxEntries <= 0 ) {
+        return 0;
+    }
+
+    Size = DeviceHandle->TraceSize;
+    Done = __atomic_load_n( &DeviceHandle->TraceDone, __ATOMIC_ACQUIRE );
+    Head = __atomic_load_n( &DeviceHandle->TraceHead, __ATOMIC_ACQUIRE );
+
+    Count = ( Head < Size ) ? Head : Size;
+    Count = ( Count > ( uint32_t ) MaxEntries ) ? ( uint32_t ) MaxEntries : Count;
+    First = Head - Count;
+
+    for ( i = 0; i < Count; i++ ) {
+        OutEntries[ i ] = Trace[ ( First + i ) % Size ];
+
+        /* Its completion time may have been half written while copying */
+        if ( ( int32_t ) ( First + i - Done ) >= 0 ) {
+            OutEntries[ i ].Completed = 0;
+        }
+    }
+
+    /*
+     * Whatever the writer got to while copying isn't the entry that was asked for,
+     * the slot at (Head) is reused next so it could have been caught half written too.
+     */
+    Head = __atomic_load_n( &DeviceHandle->TraceHead, __ATOMIC_ACQUIRE );
+    Oldest = ( Head + 1 > Size ) ? Head + 1 - Size : 0;
+
+    if ( Oldest > First ) {
+        if ( Oldest - First >= Count ) {
+            return 0;
+        }
+
+        memmove( OutEntries, &OutEntries[ Oldest - First ], ( Count - ( Oldest - First ) ) * sizeof( struct TTFT_TraceEntry ) );
+        Count-= Oldest - First;
+    }
+
+    return ( int ) Count;
+}
+
+/*
+ * TTFT_TraceCopy:
+ * Returns a newly allocated copy of the trace and sets (OutCount) to how many entries it has.
+ * Returns NULL if nothing has been recorded.
+ */
+static struct TTFT_TraceEntry* TTFT_TraceCopy( struct TTFT_Device* DeviceHandle, int* OutCount ) {
+    struct TTFT_TraceEntry* Entries = NULL;
+
+    *OutCount = 0;
+
+    if ( DeviceHandle->Trace == NULL || DeviceHandle->TraceHead == 0 ) {
+        return NULL;
+    }
+
+    NullCheck( ( Entries = malloc( DeviceHandle->TraceSize * sizeof( struct TTFT_TraceEntry ) ) ), return NULL );
+
+    if ( ( *OutCount = TTFT_TraceGet( DeviceHandle, Entries, DeviceHandle->TraceSize ) ) == 0 ) {
+        free( Entries );
+        return NULL;
+    }
+
+    return Entries;
+}
+
+/*
+ * TTFT_TraceDump:
+ * Prints the recorded entries to (fp), one per line.
+ */
+void TTFT_TraceDump( struct TTFT_Device* DeviceHandle, FILE* fp ) {
+    struct TTFT_TraceEntry* Entries = NULL;
+    struct TTFT_TraceEntry* Entry = NULL;
+    int Count = 0;
+    int i = 0;
+
+    NullCheck( DeviceHandle, return );
+    NullCheck( fp, return );
+
+    if ( ( Entries = TTFT_TraceCopy( DeviceHandle, &Count ) ) == NULL ) {
+        fprintf( fp, "No transfers traced\n" );
+        return;
+    }
+
+    /* Times are from the first entry shown */
+    fprintf( fp, "%12s %10s %8s %s\n", "queued_us", "took_us", "bytes", "type" );
+
+    for ( i = 0; i < Count; i++ ) {
+        Entry = &Entries[ i ];
+
+        fprintf( fp, "%12lld ", ( long long ) ( Entry->Queued - Entries[ 0 ].Queued ) );
+
+        if ( Entry->Completed != 0 ) {
+            fprintf( fp, "%10lld ", ( long long ) ( Entry->Completed - Entry->Queued ) );
+        }
+        else {
+            fprintf( fp, "%10s ", "-" );
+        }
+
+        if ( Entry->IsCommand == true ) {
+            fprintf( fp, "%8u command 0x%02X\n", ( unsigned ) Entry->Length, Entry->FirstByte );
+        }
+        else {
+            fprintf( fp, "%8u data\n", ( unsigned ) Entry->Length );
+        }
+    }
+
+    free( Entries );
+}
+
+/*
+ * TTFT_TraceWriteJSON:
+ * Writes the recorded entries to (fp) in the Chrome trace event format,
+ * which chrome://tracing and ui.perfetto.dev open.
+ *
+ * Queued transfers overlap so each one is an async slice from when it was queued
+ * to when it was done, transfers still in flight are left out.
+ */
+bool TTFT_TraceWriteJSON( struct TTFT_Device* DeviceHandle, FILE* fp ) {
+    struct TTFT_TraceEntry* Entries = NULL;
+    struct TTFT_TraceEntry* Entry = NULL;
+    const char* Separator = "";
+    char Name[ 16 ];
+    int Count = 0;
+    int i = 0;
+
+    NullCheck( DeviceHandle, return false );
+    NullCheck( fp, return false );
+
+    Entries = TTFT_TraceCopy( DeviceHandle, &Count );
+
+    fprintf( fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n" );
+
+    for ( i = 0; i < Count; i++ ) {
+        Entry = &Entries[ i ];
+
+        if ( Entry->Completed == 0 ) {
+            continue;
+        }
+
+        if ( Entry->IsCommand == true ) {
+            snprintf( Name, sizeof( Name ), "cmd 0x%02X", Entry->FirstByte );
+        }
+        else {
+            snprintf( Name, sizeof( Name ), "data" );
+        }
+
+        fprintf( fp, "%s{\"name\":\"%s\",\"cat\":\"spi\",\"ph\":\"b\",\"id\":%d,\"pid\":1,\"tid\":1,\"ts\":%lld,\"args\":{\"bytes\":%u}},\n",
+            Separator,
+            Name,
+            i,
+            ( long long ) Entry->Queued,
+            ( unsigned ) Entry->Length
+        );
+
+        fprintf( fp, "{\"name\":\"%s\",\"cat\":\"spi\",\"ph\":\"e\",\"id\":%d,\"pid\":1,\"tid\":1,\"ts\":%lld}",
+            Name,
+            i,
+            ( long long ) Entry->Completed
+        );
+
+        Separator = ",\n";
+    }
+
+    fprintf( fp, "\n]}\n" );
+
+    if ( Entries != NULL ) {
+        free( Entries );
+    }
+
+    return ferror( fp ) == 0;
+}
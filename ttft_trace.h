@@ -0,0 +1,79 @@
+#ifndef _TTFT_TRACE_H_
+#define _TTFT_TRACE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "ttft.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Smallest trace buffer TTFT_TraceStart takes, it has to hold every transfer
+ * that can still be queued plus some history.
+ */
+#define TTFT_TraceMinEntries ( TTFT_TransportQueueDepth * 2 )
+
+/*
+ * One transfer sent through TTFT_SPIWrite or queued by an update.
+ * Times are esp_timer_get_time microseconds.
+ */
+struct TTFT_TraceEntry {
+    /* When the transfer was handed to the transport */
+    int64_t Queued;
+
+    /* When it was known to be done, 0 while it's still queued */
+    int64_t Completed;
+
+    uint32_t Length;
+    bool IsCommand;
+
+    /* First byte of the transfer, the command for commands */
+    uint8_t FirstByte;
+};
+
+/*
+ * TTFT_TraceStart:
+ * Starts recording every transfer to (DeviceHandle) into (Entries), which holds (Count) of them
+ * and must stay around until TTFT_TraceStop. Once full the oldest entries are overwritten.
+ * Don't call this while an update is running.
+ */
+void TTFT_TraceStart( struct TTFT_Device* DeviceHandle, struct TTFT_TraceEntry* Entries, int Count );
+
+/*
+ * TTFT_TraceStop:
+ * Stops recording, (Entries) given to TTFT_TraceStart can be reused after this.
+ * Don't call this while an update is running, it could still be writing to (Entries).
+ */
+void TTFT_TraceStop( struct TTFT_Device* DeviceHandle );
+
+/*
+ * TTFT_TraceGet:
+ * Copies up to (MaxEntries) of the most recent entries into (OutEntries), oldest first.
+ * Safe to call while the display is being updated from another task, entries that got
+ * overwritten during the copy are left out and transfers that finished during the copy
+ * are shown as still in flight.
+ * Returns the number of entries copied.
+ */
+int TTFT_TraceGet( struct TTFT_Device* DeviceHandle, struct TTFT_TraceEntry* OutEntries, int MaxEntries );
+
+/*
+ * TTFT_TraceDump:
+ * Prints the recorded entries to (fp), one per line.
+ */
+void TTFT_TraceDump( struct TTFT_Device* DeviceHandle, FILE* fp );
+
+/*
+ * TTFT_TraceWriteJSON:
+ * Writes the recorded entries to (fp) in the Chrome trace event format,
+ * which chrome://tracing and ui.perfetto.dev open.
+ */
+bool TTFT_TraceWriteJSON( struct TTFT_Device* DeviceHandle, FILE* fp );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif